@@ -0,0 +1,211 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "bladeRF_AsyncStream.hpp"
+#include <SoapySDR/Errors.hpp>
+#include <SoapySDR/Logger.hpp>
+#include <stdexcept>
+#include <chrono>
+
+bladeRF_AsyncStream::bladeRF_AsyncStream(
+    bladerf *dev,
+    const bladerf_channel_layout layout,
+    const bladerf_format format,
+    const size_t numBuffs,
+    const size_t bufSize,
+    const size_t numXfers):
+    _stream(nullptr),
+    _layout(layout),
+    _isTx((layout & BLADERF_DIRECTION_MASK) == BLADERF_TX),
+    _bufSize(bufSize),
+    _numXfers(numXfers),
+    _error(0),
+    _running(false),
+    _overflow(false)
+{
+    void **buffs = nullptr;
+    const int ret = bladerf_init_stream(
+        &_stream,
+        dev,
+        &bladeRF_AsyncStream::streamCallback,
+        &buffs,
+        numBuffs,
+        format,
+        bufSize,
+        numXfers,
+        this);
+    if (ret != 0)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_init_stream() returned %d", ret);
+        throw std::runtime_error("bladerf_init_stream() " + std::string(bladerf_strerror(ret)));
+    }
+
+    for (size_t i = 0; i < numBuffs; i++)
+    {
+        _buffs.push_back(buffs[i]);
+        _buffToHandle[buffs[i]] = i;
+    }
+    this->reset();
+}
+
+bladeRF_AsyncStream::~bladeRF_AsyncStream(void)
+{
+    this->stop();
+    bladerf_deinit_stream(_stream);
+}
+
+void bladeRF_AsyncStream::reset(void)
+{
+    _ready.clear();
+    _free.clear();
+    _error = 0;
+    _overflow = false;
+
+    for (size_t i = 0; i < _buffs.size(); i++)
+    {
+        //all tx buffers start out available to be filled
+        if (_isTx) _ready.push_back(i);
+
+        //the first rx buffers are submitted as the initial transfers
+        else if (i >= _numXfers) _free.push_back(i);
+    }
+}
+
+void bladeRF_AsyncStream::start(void)
+{
+    if (_running) return;
+    this->stop(); //join a stream thread that exited on error
+    this->reset();
+    _running = true;
+    _thread = std::thread([this](void)
+    {
+        const int ret = bladerf_stream(_stream, _layout);
+        if (ret != 0) SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_stream() returned %s", bladerf_strerror(ret));
+
+        //wake up any waiters, the stream will not produce more buffers
+        std::lock_guard<std::mutex> lock(_mutex);
+        _error = ret;
+        _running = false;
+        _cond.notify_all();
+    });
+}
+
+void bladeRF_AsyncStream::stop(void)
+{
+    if (not _thread.joinable()) return;
+
+    //the callback returns shutdown to the in-flight transfers,
+    //submitting shutdown stops the stream when no transfers are in-flight
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    bladerf_submit_stream_buffer_nb(_stream, BLADERF_STREAM_SHUTDOWN);
+    _thread.join();
+}
+
+int bladeRF_AsyncStream::acquire(size_t &handle, const long timeoutUs)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    //report and clear an rx overflow before handing out more samples
+    if (_overflow)
+    {
+        _overflow = false;
+        return SOAPY_SDR_OVERFLOW;
+    }
+
+    if (_ready.empty())
+    {
+        if (not _running) return (_error != 0)?SOAPY_SDR_STREAM_ERROR:SOAPY_SDR_TIMEOUT;
+        _cond.wait_for(lock, std::chrono::microseconds(timeoutUs), [this](void)
+        {
+            return not _ready.empty() or not _running;
+        });
+        if (_ready.empty()) return (not _running and _error != 0)?SOAPY_SDR_STREAM_ERROR:SOAPY_SDR_TIMEOUT;
+    }
+
+    handle = _ready.front();
+    _ready.pop_front();
+    return 0;
+}
+
+void bladeRF_AsyncStream::release(const size_t handle)
+{
+    //tx: the buffer is available to be filled again
+    //rx: the buffer becomes the next transfer in the stream callback
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_isTx) _ready.push_front(handle);
+    else _free.push_back(handle);
+}
+
+int bladeRF_AsyncStream::submit(const size_t handle, const unsigned timeoutMs)
+{
+    return bladerf_submit_stream_buffer(_stream, _buffs.at(handle), timeoutMs);
+}
+
+void *bladeRF_AsyncStream::streamCallback(
+    bladerf *,
+    struct bladerf_stream *,
+    bladerf_metadata *,
+    void *samples,
+    size_t,
+    void *userData)
+{
+    return reinterpret_cast<bladeRF_AsyncStream *>(userData)->handleCallback(samples);
+}
+
+void *bladeRF_AsyncStream::handleCallback(void *samples)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //the completed buffer goes back to the caller,
+    //tx calls without samples while requesting the initial transfers
+    if (samples != nullptr)
+    {
+        _ready.push_back(_buffToHandle.at(samples));
+        _cond.notify_one();
+    }
+
+    if (not _running) return BLADERF_STREAM_SHUTDOWN;
+
+    //tx buffers are submitted by the caller
+    if (_isTx) return BLADERF_STREAM_NO_DATA;
+
+    //rx: recycle a released buffer as the next transfer, the transfers never go idle,
+    //so the stream does not need buffers submitted from outside of the callback
+    size_t handle = 0;
+    if (not _free.empty())
+    {
+        handle = _free.front();
+        _free.pop_front();
+    }
+
+    //otherwise the caller is behind, drop the oldest unread samples,
+    //the completed buffer was just queued so there is at least one
+    else
+    {
+        handle = _ready.front();
+        _ready.pop_front();
+        _overflow = true;
+    }
+    return _buffs.at(handle);
+}
@@ -0,0 +1,132 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <libbladeRF.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <map>
+#include <vector>
+
+/*!
+ * Wrapper around the libbladeRF asynchronous stream interface.
+ * It tracks ownership of the stream buffers so that they can be handed
+ * to the caller in place, without copying through the sync interface.
+ *
+ * RX: completed transfers are queued until acquired by the caller,
+ * released buffers are recycled as the next transfers in the stream callback.
+ * When the caller has not released any, the oldest unread buffer is dropped instead.
+ * TX: free buffers are acquired by the caller, filled, and submitted.
+ */
+class bladeRF_AsyncStream
+{
+public:
+
+    //! initialize the stream and its buffers, throws on error
+    bladeRF_AsyncStream(
+        bladerf *dev,
+        const bladerf_channel_layout layout,
+        const bladerf_format format,
+        const size_t numBuffs,
+        const size_t bufSize,
+        const size_t numXfers);
+
+    //! stops the stream and frees the buffers
+    ~bladeRF_AsyncStream(void);
+
+    //! start the stream thread
+    void start(void);
+
+    //! stop the stream thread and reclaim all buffers
+    void stop(void);
+
+    size_t getNumBuffers(void) const
+    {
+        return _buffs.size();
+    }
+
+    //! the number of samples in each buffer
+    size_t getBufferSize(void) const
+    {
+        return _bufSize;
+    }
+
+    void *getBuffer(const size_t handle) const
+    {
+        return _buffs.at(handle);
+    }
+
+    /*!
+     * Wait for a buffer to become available to the caller:
+     * a buffer of received samples (RX) or a free buffer to fill (TX).
+     * \return 0 on success, or a SoapySDR error code
+     */
+    int acquire(size_t &handle, const long timeoutUs);
+
+    //! give a buffer back to the stream: done reading (RX) or not transmitted (TX)
+    void release(const size_t handle);
+
+    /*!
+     * Submit a filled buffer for transmission (TX).
+     * The caller keeps the buffer when this fails.
+     * \return 0 on success, or a libbladeRF error code
+     */
+    int submit(const size_t handle, const unsigned timeoutMs);
+
+private:
+    static void *streamCallback(
+        bladerf *dev,
+        struct bladerf_stream *stream,
+        bladerf_metadata *md,
+        void *samples,
+        size_t numSamples,
+        void *userData);
+
+    void *handleCallback(void *samples);
+
+    void reset(void);
+
+    struct bladerf_stream *_stream;
+    const bladerf_channel_layout _layout;
+    const bool _isTx;
+    const size_t _bufSize;
+    const size_t _numXfers;
+    std::vector<void *> _buffs;
+    std::map<void *, size_t> _buffToHandle;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+
+    //! buffers ready for the caller: received (RX) or free (TX)
+    std::deque<size_t> _ready;
+
+    //! released RX buffers that are waiting to become transfers
+    std::deque<size_t> _free;
+
+    //! the bladerf_stream error when the stream thread exited on its own
+    int _error;
+
+    bool _running;
+    bool _overflow;
+};
@@ -0,0 +1,2187 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "bladeRF_Conversions.hpp"
+#include <SoapySDR/Formats.hpp>
+#include <algorithm> //min
+#include <cstring> //memcpy
+
+//the DAC takes 12-bit samples, anything outside of this range wraps around
+#define SC16_MIN (-2048)
+#define SC16_MAX 2047
+#define SC8_MIN (-128)
+#define SC8_MAX 127
+
+//shift between the Q11 and Q7 integer formats
+#define SC8_SHIFT 4
+
+//x86 kernels are compiled with per-function target attributes
+//so that a single binary can select the instruction set at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONVERT_X86
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+//neon is part of the baseline on the arm targets that define it
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+/*******************************************************************
+ * Generic kernels
+ ******************************************************************/
+
+static void sc16ToCF32_generic(const int16_t *in, float *out, const size_t len, const float scale)
+{
+    for (size_t i = 0; i < len; i++) out[i] = float(in[i])*scale;
+}
+
+static void sc8ToCF32_generic(const int8_t *in, float *out, const size_t len, const float scale)
+{
+    for (size_t i = 0; i < len; i++) out[i] = float(in[i])*scale;
+}
+
+//written so that NaN ends up on the lower rail
+static inline int saturate(const float in, const int lo, const int hi)
+{
+    if (in > hi) return hi;
+    if (in >= lo) return int(in);
+    return lo;
+}
+
+static inline int16_t widenSC8(const int8_t in)
+{
+    return int16_t(in*(1 << SC8_SHIFT));
+}
+
+static inline int8_t narrowSC16(const int16_t in)
+{
+    const int out = in >> SC8_SHIFT;
+    return int8_t((out > SC8_MAX)?SC8_MAX:((out < SC8_MIN)?SC8_MIN:out));
+}
+
+static void sc8ToSC16_generic(const int8_t *in, int16_t *out, const size_t len)
+{
+    for (size_t i = 0; i < len; i++) out[i] = widenSC8(in[i]);
+}
+
+static void sc16ToSC8_generic(const int16_t *in, int8_t *out, const size_t len)
+{
+    for (size_t i = 0; i < len; i++) out[i] = narrowSC16(in[i]);
+}
+
+//each complex sample is 3 bytes, I in the low 12 bits and Q in the high 12 bits
+static inline void unpackSC12(const uint8_t *in, int16_t *out)
+{
+    const int lo = in[0] | (in[1] << 8);
+    const int hi = in[1] | (in[2] << 8);
+    out[0] = int16_t(int16_t(uint16_t(lo << 4)) >> 4);
+    out[1] = int16_t(int16_t(uint16_t(hi)) >> 4);
+}
+
+static void sc12ToSC16_generic(const uint8_t *in, int16_t *out, const size_t len)
+{
+    for (size_t i = 0; i + 2 <= len; i += 2) unpackSC12(in+3*i/2, out+i);
+}
+
+static void sc12ToCF32_generic(const uint8_t *in, float *out, const size_t len, const float scale)
+{
+    int16_t iq[2];
+    for (size_t i = 0; i + 2 <= len; i += 2)
+    {
+        unpackSC12(in+3*i/2, iq);
+        out[i+0] = float(iq[0])*scale;
+        out[i+1] = float(iq[1])*scale;
+    }
+}
+
+static void sc12ToSC8_generic(const uint8_t *in, int8_t *out, const size_t len)
+{
+    int16_t iq[2];
+    for (size_t i = 0; i + 2 <= len; i += 2)
+    {
+        unpackSC12(in+3*i/2, iq);
+        out[i+0] = narrowSC16(iq[0]);
+        out[i+1] = narrowSC16(iq[1]);
+    }
+}
+
+static inline int16_t clipSC12(const int16_t in)
+{
+    return int16_t((in > SC16_MAX)?SC16_MAX:((in < SC16_MIN)?SC16_MIN:in));
+}
+
+//the inputs must already be within the 12-bit range
+static inline void packSC12(const int16_t i, const int16_t q, uint8_t *out)
+{
+    out[0] = uint8_t(i);
+    out[1] = uint8_t(((i >> 8) & 0xf) | (q << 4));
+    out[2] = uint8_t(q >> 4);
+}
+
+static void sc16ToSC12_generic(const int16_t *in, uint8_t *out, const size_t len)
+{
+    for (size_t i = 0; i + 2 <= len; i += 2) packSC12(clipSC12(in[i+0]), clipSC12(in[i+1]), out+3*i/2);
+}
+
+static void sc8ToSC12_generic(const int8_t *in, uint8_t *out, const size_t len)
+{
+    for (size_t i = 0; i + 2 <= len; i += 2) packSC12(widenSC8(in[i+0]), widenSC8(in[i+1]), out+3*i/2);
+}
+
+static void cf32ToSC16_generic(const float *in, int16_t *out, const size_t len, const float scale)
+{
+    for (size_t i = 0; i < len; i++) out[i] = int16_t(saturate(in[i]*scale, SC16_MIN, SC16_MAX));
+}
+
+static void cf32ToSC8_generic(const float *in, int8_t *out, const size_t len, const float scale)
+{
+    for (size_t i = 0; i < len; i++) out[i] = int8_t(saturate(in[i]*scale, SC8_MIN, SC8_MAX));
+}
+
+static void cf32ToSC12_generic(const float *in, uint8_t *out, const size_t len, const float scale)
+{
+    for (size_t i = 0; i + 2 <= len; i += 2)
+    {
+        const int16_t iv = int16_t(saturate(in[i+0]*scale, SC16_MIN, SC16_MAX));
+        const int16_t qv = int16_t(saturate(in[i+1]*scale, SC16_MIN, SC16_MAX));
+        packSC12(iv, qv, out+3*i/2);
+    }
+}
+
+//complex samples alternate between the channels on the wire
+template <typename InType, typename OutType, typename Fcn>
+static inline void deinterleave(const InType *in, OutType *out0, OutType *out1, const size_t numElems, const Fcn &fcn)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        *(out0++) = fcn(*(in++));
+        *(out0++) = fcn(*(in++));
+        *(out1++) = fcn(*(in++));
+        *(out1++) = fcn(*(in++));
+    }
+}
+
+template <typename InType, typename OutType, typename Fcn>
+static inline void interleave(const InType *in0, const InType *in1, OutType *out, const size_t numElems, const Fcn &fcn)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        *(out++) = fcn(*(in0++));
+        *(out++) = fcn(*(in0++));
+        *(out++) = fcn(*(in1++));
+        *(out++) = fcn(*(in1++));
+    }
+}
+
+static void deinterleaveSC16_generic(const int16_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    deinterleave(in, out0, out1, numElems, [](const int16_t x){return x;});
+}
+
+static void deinterleaveSC8_generic(const int8_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    deinterleave(in, out0, out1, numElems, [](const int8_t x){return x;});
+}
+
+//the 12-bit samples are moved as whole 3 byte groups
+static void deinterleaveSC12_generic(const uint8_t *in, uint8_t *out0, uint8_t *out1, const size_t numElems)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        std::memcpy(out0+3*i, in+6*i+0, 3);
+        std::memcpy(out1+3*i, in+6*i+3, 3);
+    }
+}
+
+static void deinterleaveSC16ToCF32_generic(const int16_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    deinterleave(in, out0, out1, numElems, [scale](const int16_t x){return float(x)*scale;});
+}
+
+static void deinterleaveSC8ToCF32_generic(const int8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    deinterleave(in, out0, out1, numElems, [scale](const int8_t x){return float(x)*scale;});
+}
+
+static void deinterleaveSC16ToSC8_generic(const int16_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    deinterleave(in, out0, out1, numElems, &narrowSC16);
+}
+
+static void deinterleaveSC8ToSC16_generic(const int8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    deinterleave(in, out0, out1, numElems, &widenSC8);
+}
+
+static void deinterleaveSC12ToSC16_generic(const uint8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        unpackSC12(in+6*i+0, out0+2*i);
+        unpackSC12(in+6*i+3, out1+2*i);
+    }
+}
+
+static void deinterleaveSC12ToCF32_generic(const uint8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        int16_t iq[4];
+        unpackSC12(in+6*i+0, iq+0);
+        unpackSC12(in+6*i+3, iq+2);
+        out0[2*i+0] = float(iq[0])*scale;
+        out0[2*i+1] = float(iq[1])*scale;
+        out1[2*i+0] = float(iq[2])*scale;
+        out1[2*i+1] = float(iq[3])*scale;
+    }
+}
+
+static void deinterleaveSC12ToSC8_generic(const uint8_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        sc12ToSC8_generic(in+6*i+0, out0+2*i, 2);
+        sc12ToSC8_generic(in+6*i+3, out1+2*i, 2);
+    }
+}
+
+static void interleaveSC16_generic(const int16_t *in0, const int16_t *in1, int16_t *out, const size_t numElems)
+{
+    interleave(in0, in1, out, numElems, [](const int16_t x){return x;});
+}
+
+static void interleaveSC8_generic(const int8_t *in0, const int8_t *in1, int8_t *out, const size_t numElems)
+{
+    interleave(in0, in1, out, numElems, [](const int8_t x){return x;});
+}
+
+static void interleaveSC12_generic(const uint8_t *in0, const uint8_t *in1, uint8_t *out, const size_t numElems)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        std::memcpy(out+6*i+0, in0+3*i, 3);
+        std::memcpy(out+6*i+3, in1+3*i, 3);
+    }
+}
+
+static void interleaveCF32ToSC16_generic(const float *in0, const float *in1, int16_t *out, const size_t numElems, const float scale)
+{
+    interleave(in0, in1, out, numElems, [scale](const float x){return int16_t(saturate(x*scale, SC16_MIN, SC16_MAX));});
+}
+
+static void interleaveCF32ToSC8_generic(const float *in0, const float *in1, int8_t *out, const size_t numElems, const float scale)
+{
+    interleave(in0, in1, out, numElems, [scale](const float x){return int8_t(saturate(x*scale, SC8_MIN, SC8_MAX));});
+}
+
+static void interleaveSC16ToSC8_generic(const int16_t *in0, const int16_t *in1, int8_t *out, const size_t numElems)
+{
+    interleave(in0, in1, out, numElems, &narrowSC16);
+}
+
+static void interleaveSC8ToSC16_generic(const int8_t *in0, const int8_t *in1, int16_t *out, const size_t numElems)
+{
+    interleave(in0, in1, out, numElems, &widenSC8);
+}
+
+static void interleaveSC16ToSC12_generic(const int16_t *in0, const int16_t *in1, uint8_t *out, const size_t numElems)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        packSC12(clipSC12(in0[2*i+0]), clipSC12(in0[2*i+1]), out+6*i+0);
+        packSC12(clipSC12(in1[2*i+0]), clipSC12(in1[2*i+1]), out+6*i+3);
+    }
+}
+
+static void interleaveCF32ToSC12_generic(const float *in0, const float *in1, uint8_t *out, const size_t numElems, const float scale)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        cf32ToSC12_generic(in0+2*i, out+6*i+0, 2, scale);
+        cf32ToSC12_generic(in1+2*i, out+6*i+3, 2, scale);
+    }
+}
+
+static void interleaveSC8ToSC12_generic(const int8_t *in0, const int8_t *in1, uint8_t *out, const size_t numElems)
+{
+    for (size_t i = 0; i < numElems; i++)
+    {
+        packSC12(widenSC8(in0[2*i+0]), widenSC8(in0[2*i+1]), out+6*i+0);
+        packSC12(widenSC8(in1[2*i+0]), widenSC8(in1[2*i+1]), out+6*i+3);
+    }
+}
+
+/*******************************************************************
+ * SSE2 kernels
+ ******************************************************************/
+#ifdef CONVERT_X86
+
+TARGET("sse2")
+static void sc16ToCF32_sse2(const int16_t *in, float *out, const size_t len, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(in+i));
+
+        //sign extend by moving each value into the upper half of a 32-bit lane
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(out+i+0, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    sc16ToCF32_generic(in+i, out+i, len-i, scale);
+}
+
+TARGET("sse2")
+static void sc8ToCF32_sse2(const int8_t *in, float *out, const size_t len, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(in+i));
+
+        //sign extend by moving each value into the top byte of a 32-bit lane
+        const __m128i v16lo = _mm_unpacklo_epi8(v, v);
+        const __m128i v16hi = _mm_unpackhi_epi8(v, v);
+        const __m128i v0 = _mm_srai_epi32(_mm_unpacklo_epi16(v16lo, v16lo), 24);
+        const __m128i v1 = _mm_srai_epi32(_mm_unpackhi_epi16(v16lo, v16lo), 24);
+        const __m128i v2 = _mm_srai_epi32(_mm_unpacklo_epi16(v16hi, v16hi), 24);
+        const __m128i v3 = _mm_srai_epi32(_mm_unpackhi_epi16(v16hi, v16hi), 24);
+
+        _mm_storeu_ps(out+i+0, _mm_mul_ps(_mm_cvtepi32_ps(v0), s));
+        _mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(v1), s));
+        _mm_storeu_ps(out+i+8, _mm_mul_ps(_mm_cvtepi32_ps(v2), s));
+        _mm_storeu_ps(out+i+12, _mm_mul_ps(_mm_cvtepi32_ps(v3), s));
+    }
+    sc8ToCF32_generic(in+i, out+i, len-i, scale);
+}
+
+//clip in the float domain so that the integer conversion cannot overflow
+TARGET("sse2")
+static inline __m128i cvtSC16_sse2(const __m128 in, const __m128 scale)
+{
+    const __m128 clipped = _mm_min_ps(_mm_max_ps(_mm_mul_ps(in, scale), _mm_set1_ps(SC16_MIN)), _mm_set1_ps(SC16_MAX));
+    return _mm_cvttps_epi32(clipped);
+}
+
+TARGET("sse2")
+static void cf32ToSC16_sse2(const float *in, int16_t *out, const size_t len, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m128i lo = cvtSC16_sse2(_mm_loadu_ps(in+i+0), s);
+        const __m128i hi = cvtSC16_sse2(_mm_loadu_ps(in+i+4), s);
+        _mm_storeu_si128((__m128i *)(out+i), _mm_packs_epi32(lo, hi));
+    }
+    cf32ToSC16_generic(in+i, out+i, len-i, scale);
+}
+
+TARGET("sse2")
+static void interleaveCF32ToSC16_sse2(const float *in0, const float *in1, int16_t *out, const size_t numElems, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128d a0 = _mm_castps_pd(_mm_loadu_ps(in0+2*i+0));
+        const __m128d a1 = _mm_castps_pd(_mm_loadu_ps(in0+2*i+4));
+        const __m128d b0 = _mm_castps_pd(_mm_loadu_ps(in1+2*i+0));
+        const __m128d b1 = _mm_castps_pd(_mm_loadu_ps(in1+2*i+4));
+
+        //each complex float is 64 bits, alternate them between the channels
+        const __m128i x0 = cvtSC16_sse2(_mm_castpd_ps(_mm_unpacklo_pd(a0, b0)), s);
+        const __m128i x1 = cvtSC16_sse2(_mm_castpd_ps(_mm_unpackhi_pd(a0, b0)), s);
+        const __m128i x2 = cvtSC16_sse2(_mm_castpd_ps(_mm_unpacklo_pd(a1, b1)), s);
+        const __m128i x3 = cvtSC16_sse2(_mm_castpd_ps(_mm_unpackhi_pd(a1, b1)), s);
+
+        _mm_storeu_si128((__m128i *)(out+4*i+0), _mm_packs_epi32(x0, x1));
+        _mm_storeu_si128((__m128i *)(out+4*i+8), _mm_packs_epi32(x2, x3));
+    }
+    interleaveCF32ToSC16_generic(in0+2*i, in1+2*i, out+4*i, numElems-i, scale);
+}
+
+TARGET("sse2")
+static void sc8ToSC16_sse2(const int8_t *in, int16_t *out, const size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        //place each byte in the upper half of a 16-bit lane, then shift down to Q11
+        const __m128i v = _mm_loadu_si128((const __m128i *)(in+i));
+        const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(zero, v), 8-SC8_SHIFT);
+        const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(zero, v), 8-SC8_SHIFT);
+        _mm_storeu_si128((__m128i *)(out+i+0), lo);
+        _mm_storeu_si128((__m128i *)(out+i+8), hi);
+    }
+    sc8ToSC16_generic(in+i, out+i, len-i);
+}
+
+TARGET("sse2")
+static void sc16ToSC8_sse2(const int16_t *in, int8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i lo = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)(in+i+0)), SC8_SHIFT);
+        const __m128i hi = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)(in+i+8)), SC8_SHIFT);
+        _mm_storeu_si128((__m128i *)(out+i), _mm_packs_epi16(lo, hi));
+    }
+    sc16ToSC8_generic(in+i, out+i, len-i);
+}
+
+TARGET("sse2")
+static inline __m128i cvtSC8_sse2(const __m128 in, const __m128 scale)
+{
+    const __m128 clipped = _mm_min_ps(_mm_max_ps(_mm_mul_ps(in, scale), _mm_set1_ps(SC8_MIN)), _mm_set1_ps(SC8_MAX));
+    return _mm_cvttps_epi32(clipped);
+}
+
+TARGET("sse2")
+static void cf32ToSC8_sse2(const float *in, int8_t *out, const size_t len, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i v0 = cvtSC8_sse2(_mm_loadu_ps(in+i+0), s);
+        const __m128i v1 = cvtSC8_sse2(_mm_loadu_ps(in+i+4), s);
+        const __m128i v2 = cvtSC8_sse2(_mm_loadu_ps(in+i+8), s);
+        const __m128i v3 = cvtSC8_sse2(_mm_loadu_ps(in+i+12), s);
+        const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+        _mm_storeu_si128((__m128i *)(out+i), packed);
+    }
+    cf32ToSC8_generic(in+i, out+i, len-i, scale);
+}
+
+//group the 32-bit complex samples of two vectors by channel
+TARGET("sse2")
+static inline void splitSC16_sse2(const __m128i v0, const __m128i v1, __m128i &ch0, __m128i &ch1)
+{
+    const __m128i s0 = _mm_shuffle_epi32(v0, 0xd8);
+    const __m128i s1 = _mm_shuffle_epi32(v1, 0xd8);
+    ch0 = _mm_unpacklo_epi64(s0, s1);
+    ch1 = _mm_unpackhi_epi64(s0, s1);
+}
+
+//group the 16-bit complex samples by channel: ch0 in the low half, ch1 in the high half
+TARGET("sse2")
+static inline __m128i splitSC8_sse2(const __m128i v)
+{
+    const __m128i w = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xd8), 0xd8);
+    return _mm_shuffle_epi32(w, 0xd8);
+}
+
+//sign extend 8 shorts and store them as scaled floats
+TARGET("sse2")
+static inline void storeCF32_sse2(float *out, const __m128i v, const __m128 scale)
+{
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(out+0, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(out+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+}
+
+TARGET("sse2")
+static void deinterleaveSC16_sse2(const int16_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        __m128i ch0, ch1;
+        splitSC16_sse2(_mm_loadu_si128((const __m128i *)(in+4*i+0)), _mm_loadu_si128((const __m128i *)(in+4*i+8)), ch0, ch1);
+        _mm_storeu_si128((__m128i *)(out0+2*i), ch0);
+        _mm_storeu_si128((__m128i *)(out1+2*i), ch1);
+    }
+    deinterleaveSC16_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("sse2")
+static void deinterleaveSC16ToCF32_sse2(const int16_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        __m128i ch0, ch1;
+        splitSC16_sse2(_mm_loadu_si128((const __m128i *)(in+4*i+0)), _mm_loadu_si128((const __m128i *)(in+4*i+8)), ch0, ch1);
+        storeCF32_sse2(out0+2*i, ch0, s);
+        storeCF32_sse2(out1+2*i, ch1, s);
+    }
+    deinterleaveSC16ToCF32_generic(in+4*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+TARGET("sse2")
+static void deinterleaveSC16ToSC8_sse2(const int16_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        __m128i ch0, ch1;
+        splitSC16_sse2(_mm_loadu_si128((const __m128i *)(in+4*i+0)), _mm_loadu_si128((const __m128i *)(in+4*i+8)), ch0, ch1);
+        const __m128i v = _mm_packs_epi16(_mm_srai_epi16(ch0, SC8_SHIFT), _mm_srai_epi16(ch1, SC8_SHIFT));
+        _mm_storel_epi64((__m128i *)(out0+2*i), v);
+        _mm_storel_epi64((__m128i *)(out1+2*i), _mm_unpackhi_epi64(v, v));
+    }
+    deinterleaveSC16ToSC8_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("sse2")
+static void deinterleaveSC8_sse2(const int8_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i v = splitSC8_sse2(_mm_loadu_si128((const __m128i *)(in+4*i)));
+        _mm_storel_epi64((__m128i *)(out0+2*i), v);
+        _mm_storel_epi64((__m128i *)(out1+2*i), _mm_unpackhi_epi64(v, v));
+    }
+    deinterleaveSC8_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("sse2")
+static void deinterleaveSC8ToCF32_sse2(const int8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i v = splitSC8_sse2(_mm_loadu_si128((const __m128i *)(in+4*i)));
+        storeCF32_sse2(out0+2*i, _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8), s);
+        storeCF32_sse2(out1+2*i, _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8), s);
+    }
+    deinterleaveSC8ToCF32_generic(in+4*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+TARGET("sse2")
+static void deinterleaveSC8ToSC16_sse2(const int8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i v = splitSC8_sse2(_mm_loadu_si128((const __m128i *)(in+4*i)));
+        _mm_storeu_si128((__m128i *)(out0+2*i), _mm_srai_epi16(_mm_unpacklo_epi8(zero, v), 8-SC8_SHIFT));
+        _mm_storeu_si128((__m128i *)(out1+2*i), _mm_srai_epi16(_mm_unpackhi_epi8(zero, v), 8-SC8_SHIFT));
+    }
+    deinterleaveSC8ToSC16_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("sse2")
+static void interleaveSC16_sse2(const int16_t *in0, const int16_t *in1, int16_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(in1+2*i));
+        _mm_storeu_si128((__m128i *)(out+4*i+0), _mm_unpacklo_epi32(a, b));
+        _mm_storeu_si128((__m128i *)(out+4*i+8), _mm_unpackhi_epi32(a, b));
+    }
+    interleaveSC16_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+TARGET("sse2")
+static void interleaveSC8_sse2(const int8_t *in0, const int8_t *in1, int8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i a = _mm_loadl_epi64((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadl_epi64((const __m128i *)(in1+2*i));
+        _mm_storeu_si128((__m128i *)(out+4*i), _mm_unpacklo_epi16(a, b));
+    }
+    interleaveSC8_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+TARGET("sse2")
+static void interleaveSC16ToSC8_sse2(const int16_t *in0, const int16_t *in1, int8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(in1+2*i));
+        const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi32(a, b), SC8_SHIFT);
+        const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi32(a, b), SC8_SHIFT);
+        _mm_storeu_si128((__m128i *)(out+4*i), _mm_packs_epi16(lo, hi));
+    }
+    interleaveSC16ToSC8_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+TARGET("sse2")
+static void interleaveSC8ToSC16_sse2(const int8_t *in0, const int8_t *in1, int16_t *out, const size_t numElems)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i a = _mm_loadl_epi64((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadl_epi64((const __m128i *)(in1+2*i));
+        const __m128i v = _mm_unpacklo_epi16(a, b);
+        _mm_storeu_si128((__m128i *)(out+4*i+0), _mm_srai_epi16(_mm_unpacklo_epi8(zero, v), 8-SC8_SHIFT));
+        _mm_storeu_si128((__m128i *)(out+4*i+8), _mm_srai_epi16(_mm_unpackhi_epi8(zero, v), 8-SC8_SHIFT));
+    }
+    interleaveSC8ToSC16_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+TARGET("sse2")
+static void interleaveCF32ToSC8_sse2(const float *in0, const float *in1, int8_t *out, const size_t numElems, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128d a0 = _mm_castps_pd(_mm_loadu_ps(in0+2*i+0));
+        const __m128d a1 = _mm_castps_pd(_mm_loadu_ps(in0+2*i+4));
+        const __m128d b0 = _mm_castps_pd(_mm_loadu_ps(in1+2*i+0));
+        const __m128d b1 = _mm_castps_pd(_mm_loadu_ps(in1+2*i+4));
+        const __m128i x0 = cvtSC8_sse2(_mm_castpd_ps(_mm_unpacklo_pd(a0, b0)), s);
+        const __m128i x1 = cvtSC8_sse2(_mm_castpd_ps(_mm_unpackhi_pd(a0, b0)), s);
+        const __m128i x2 = cvtSC8_sse2(_mm_castpd_ps(_mm_unpacklo_pd(a1, b1)), s);
+        const __m128i x3 = cvtSC8_sse2(_mm_castpd_ps(_mm_unpackhi_pd(a1, b1)), s);
+        _mm_storeu_si128((__m128i *)(out+4*i), _mm_packs_epi16(_mm_packs_epi32(x0, x1), _mm_packs_epi32(x2, x3)));
+    }
+    interleaveCF32ToSC8_generic(in0+2*i, in1+2*i, out+4*i, numElems-i, scale);
+}
+
+/*******************************************************************
+ * SSSE3 kernels
+ ******************************************************************/
+
+//gather the 3 bytes of each complex sample into two 16-bit lanes,
+//I from bytes 0-1 and Q from bytes 1-2, then shift out the neighboring nibbles:
+//I is moved to the top of its lane with a multiply by 16, both are sign extended down
+TARGET("ssse3")
+static inline __m128i unpackSC12_ssse3(const uint8_t *in)
+{
+    const __m128i order = _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m128i shift = _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1);
+    const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in), order);
+    return _mm_srai_epi16(_mm_mullo_epi16(v, shift), 4);
+}
+
+//merge each complex sample into the low 24 bits of its 32-bit lane,
+//then squeeze out the top byte of every lane into 12 contiguous bytes
+TARGET("ssse3")
+static inline __m128i packSC12_ssse3(const __m128i v)
+{
+    const __m128i order = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m128i i = _mm_and_si128(v, _mm_set1_epi32(0x00000fff));
+    const __m128i q = _mm_and_si128(_mm_srli_epi32(v, 4), _mm_set1_epi32(0x00fff000));
+    return _mm_shuffle_epi8(_mm_or_si128(i, q), order);
+}
+
+TARGET("ssse3")
+static inline __m128i clipSC12_ssse3(const __m128i v)
+{
+    return _mm_min_epi16(_mm_max_epi16(v, _mm_set1_epi16(SC16_MIN)), _mm_set1_epi16(SC16_MAX));
+}
+
+//the loops below load or store 16 bytes to handle 12, the bounds leave room for the overlap
+
+TARGET("ssse3")
+static void sc12ToSC16_ssse3(const uint8_t *in, int16_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 8)
+    {
+        _mm_storeu_si128((__m128i *)(out+i), unpackSC12_ssse3(in+3*i/2));
+    }
+    sc12ToSC16_generic(in+3*i/2, out+i, len-i);
+}
+
+TARGET("ssse3")
+static void sc12ToCF32_ssse3(const uint8_t *in, float *out, const size_t len, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 8)
+    {
+        const __m128i v = unpackSC12_ssse3(in+3*i/2);
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out+i+0, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    sc12ToCF32_generic(in+3*i/2, out+i, len-i, scale);
+}
+
+TARGET("ssse3")
+static void deinterleaveSC12ToSC16_ssse3(const uint8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 2)
+    {
+        //group the 32-bit complex samples by channel
+        const __m128i v = _mm_shuffle_epi32(unpackSC12_ssse3(in+6*i), 0xd8);
+        _mm_storel_epi64((__m128i *)(out0+2*i), v);
+        _mm_storel_epi64((__m128i *)(out1+2*i), _mm_unpackhi_epi64(v, v));
+    }
+    deinterleaveSC12ToSC16_generic(in+6*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("ssse3")
+static void deinterleaveSC12ToCF32_ssse3(const uint8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 2)
+    {
+        const __m128i v = _mm_shuffle_epi32(unpackSC12_ssse3(in+6*i), 0xd8);
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out0+2*i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out1+2*i, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    deinterleaveSC12ToCF32_generic(in+6*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+TARGET("ssse3")
+static void sc16ToSC12_ssse3(const int16_t *in, uint8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 8)
+    {
+        const __m128i v = clipSC12_ssse3(_mm_loadu_si128((const __m128i *)(in+i)));
+        _mm_storeu_si128((__m128i *)(out+3*i/2), packSC12_ssse3(v));
+    }
+    sc16ToSC12_generic(in+i, out+3*i/2, len-i);
+}
+
+TARGET("ssse3")
+static void cf32ToSC12_ssse3(const float *in, uint8_t *out, const size_t len, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 8)
+    {
+        const __m128i lo = cvtSC16_sse2(_mm_loadu_ps(in+i+0), s);
+        const __m128i hi = cvtSC16_sse2(_mm_loadu_ps(in+i+4), s);
+        _mm_storeu_si128((__m128i *)(out+3*i/2), packSC12_ssse3(_mm_packs_epi32(lo, hi)));
+    }
+    cf32ToSC12_generic(in+i, out+3*i/2, len-i, scale);
+}
+
+TARGET("ssse3")
+static void interleaveSC16ToSC12_ssse3(const int16_t *in0, const int16_t *in1, uint8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 2)
+    {
+        //alternate the 32-bit complex samples between the channels
+        const __m128i a = _mm_loadl_epi64((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadl_epi64((const __m128i *)(in1+2*i));
+        const __m128i v = clipSC12_ssse3(_mm_unpacklo_epi32(a, b));
+        _mm_storeu_si128((__m128i *)(out+6*i), packSC12_ssse3(v));
+    }
+    interleaveSC16ToSC12_generic(in0+2*i, in1+2*i, out+6*i, numElems-i);
+}
+
+TARGET("ssse3")
+static void interleaveCF32ToSC12_ssse3(const float *in0, const float *in1, uint8_t *out, const size_t numElems, const float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 2)
+    {
+        //each complex float is 64 bits, alternate them between the channels
+        const __m128d a = _mm_castps_pd(_mm_loadu_ps(in0+2*i));
+        const __m128d b = _mm_castps_pd(_mm_loadu_ps(in1+2*i));
+        const __m128i x0 = cvtSC16_sse2(_mm_castpd_ps(_mm_unpacklo_pd(a, b)), s);
+        const __m128i x1 = cvtSC16_sse2(_mm_castpd_ps(_mm_unpackhi_pd(a, b)), s);
+        _mm_storeu_si128((__m128i *)(out+6*i), packSC12_ssse3(_mm_packs_epi32(x0, x1)));
+    }
+    interleaveCF32ToSC12_generic(in0+2*i, in1+2*i, out+6*i, numElems-i, scale);
+}
+
+TARGET("ssse3")
+static void deinterleaveSC12_ssse3(const uint8_t *in, uint8_t *out0, uint8_t *out1, const size_t numElems)
+{
+    //gather 2 samples of each channel into the halves, the last 2 bytes of each half are unused
+    const __m128i order = _mm_setr_epi8(0, 1, 2, 6, 7, 8, -1, -1, 3, 4, 5, 9, 10, 11, -1, -1);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 2)
+    {
+        const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in+6*i)), order);
+        _mm_storel_epi64((__m128i *)(out0+3*i), v);
+        _mm_storel_epi64((__m128i *)(out1+3*i), _mm_unpackhi_epi64(v, v));
+    }
+    deinterleaveSC12_generic(in+6*i, out0+3*i, out1+3*i, numElems-i);
+}
+
+TARGET("ssse3")
+static void interleaveSC12_ssse3(const uint8_t *in0, const uint8_t *in1, uint8_t *out, const size_t numElems)
+{
+    const __m128i order = _mm_setr_epi8(0, 1, 2, 8, 9, 10, 3, 4, 5, 11, 12, 13, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 2)
+    {
+        const __m128i a = _mm_loadl_epi64((const __m128i *)(in0+3*i));
+        const __m128i b = _mm_loadl_epi64((const __m128i *)(in1+3*i));
+        _mm_storeu_si128((__m128i *)(out+6*i), _mm_shuffle_epi8(_mm_unpacklo_epi64(a, b), order));
+    }
+    interleaveSC12_generic(in0+3*i, in1+3*i, out+6*i, numElems-i);
+}
+
+TARGET("ssse3")
+static void sc12ToSC8_ssse3(const uint8_t *in, int8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 8)
+    {
+        const __m128i v = _mm_srai_epi16(unpackSC12_ssse3(in+3*i/2), SC8_SHIFT);
+        _mm_storel_epi64((__m128i *)(out+i), _mm_packs_epi16(v, v));
+    }
+    sc12ToSC8_generic(in+3*i/2, out+i, len-i);
+}
+
+TARGET("ssse3")
+static void deinterleaveSC12ToSC8_ssse3(const uint8_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 4)
+    {
+        __m128i ch0, ch1;
+        splitSC16_sse2(unpackSC12_ssse3(in+6*i+0), unpackSC12_ssse3(in+6*i+12), ch0, ch1);
+        const __m128i v = _mm_packs_epi16(_mm_srai_epi16(ch0, SC8_SHIFT), _mm_srai_epi16(ch1, SC8_SHIFT));
+        _mm_storel_epi64((__m128i *)(out0+2*i), v);
+        _mm_storel_epi64((__m128i *)(out1+2*i), _mm_unpackhi_epi64(v, v));
+    }
+    deinterleaveSC12ToSC8_generic(in+6*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("ssse3")
+static void sc8ToSC12_ssse3(const int8_t *in, uint8_t *out, const size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 8)
+    {
+        const __m128i v = _mm_loadl_epi64((const __m128i *)(in+i));
+        const __m128i w = _mm_srai_epi16(_mm_unpacklo_epi8(zero, v), 8-SC8_SHIFT);
+        _mm_storeu_si128((__m128i *)(out+3*i/2), packSC12_ssse3(w));
+    }
+    sc8ToSC12_generic(in+i, out+3*i/2, len-i);
+}
+
+TARGET("ssse3")
+static void interleaveSC8ToSC12_ssse3(const int8_t *in0, const int8_t *in1, uint8_t *out, const size_t numElems)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 4)
+    {
+        const __m128i a = _mm_loadl_epi64((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadl_epi64((const __m128i *)(in1+2*i));
+        const __m128i v = _mm_unpacklo_epi16(a, b);
+        _mm_storeu_si128((__m128i *)(out+6*i+0), packSC12_ssse3(_mm_srai_epi16(_mm_unpacklo_epi8(zero, v), 8-SC8_SHIFT)));
+        _mm_storeu_si128((__m128i *)(out+6*i+12), packSC12_ssse3(_mm_srai_epi16(_mm_unpackhi_epi8(zero, v), 8-SC8_SHIFT)));
+    }
+    interleaveSC8ToSC12_generic(in0+2*i, in1+2*i, out+6*i, numElems-i);
+}
+
+/*******************************************************************
+ * AVX2 kernels
+ ******************************************************************/
+
+TARGET("avx2")
+static void sc16ToCF32_avx2(const int16_t *in, float *out, const size_t len, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in+i+0)));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in+i+8)));
+        _mm256_storeu_ps(out+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    sc16ToCF32_sse2(in+i, out+i, len-i, scale);
+}
+
+TARGET("avx2")
+static void sc8ToCF32_avx2(const int8_t *in, float *out, const size_t len, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(in+i));
+        const __m256i lo = _mm256_cvtepi8_epi32(v);
+        const __m256i hi = _mm256_cvtepi8_epi32(_mm_unpackhi_epi64(v, v));
+        _mm256_storeu_ps(out+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    sc8ToCF32_sse2(in+i, out+i, len-i, scale);
+}
+
+TARGET("avx2")
+static inline __m256i cvtSC16_avx2(const __m256 in, const __m256 scale)
+{
+    const __m256 clipped = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(in, scale), _mm256_set1_ps(SC16_MIN)), _mm256_set1_ps(SC16_MAX));
+    return _mm256_cvttps_epi32(clipped);
+}
+
+TARGET("avx2")
+static void cf32ToSC16_avx2(const float *in, int16_t *out, const size_t len, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m256i lo = cvtSC16_avx2(_mm256_loadu_ps(in+i+0), s);
+        const __m256i hi = cvtSC16_avx2(_mm256_loadu_ps(in+i+8), s);
+
+        //the pack works within 128-bit lanes, restore the sample order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+        _mm256_storeu_si256((__m256i *)(out+i), packed);
+    }
+    cf32ToSC16_sse2(in+i, out+i, len-i, scale);
+}
+
+TARGET("avx2")
+static void interleaveCF32ToSC16_avx2(const float *in0, const float *in1, int16_t *out, const size_t numElems, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const __m256d a0 = _mm256_castps_pd(_mm256_loadu_ps(in0+2*i+0));
+        const __m256d a1 = _mm256_castps_pd(_mm256_loadu_ps(in0+2*i+8));
+        const __m256d b0 = _mm256_castps_pd(_mm256_loadu_ps(in1+2*i+0));
+        const __m256d b1 = _mm256_castps_pd(_mm256_loadu_ps(in1+2*i+8));
+
+        //alternate the 64-bit complex floats between channels,
+        //the unpacks work within 128-bit lanes so the lanes are regrouped after
+        const __m256d lo0 = _mm256_unpacklo_pd(a0, b0);
+        const __m256d hi0 = _mm256_unpackhi_pd(a0, b0);
+        const __m256d lo1 = _mm256_unpacklo_pd(a1, b1);
+        const __m256d hi1 = _mm256_unpackhi_pd(a1, b1);
+        const __m256i x0 = cvtSC16_avx2(_mm256_castpd_ps(_mm256_permute2f128_pd(lo0, hi0, 0x20)), s);
+        const __m256i x1 = cvtSC16_avx2(_mm256_castpd_ps(_mm256_permute2f128_pd(lo0, hi0, 0x31)), s);
+        const __m256i x2 = cvtSC16_avx2(_mm256_castpd_ps(_mm256_permute2f128_pd(lo1, hi1, 0x20)), s);
+        const __m256i x3 = cvtSC16_avx2(_mm256_castpd_ps(_mm256_permute2f128_pd(lo1, hi1, 0x31)), s);
+
+        _mm256_storeu_si256((__m256i *)(out+4*i+0), _mm256_permute4x64_epi64(_mm256_packs_epi32(x0, x1), 0xd8));
+        _mm256_storeu_si256((__m256i *)(out+4*i+16), _mm256_permute4x64_epi64(_mm256_packs_epi32(x2, x3), 0xd8));
+    }
+    interleaveCF32ToSC16_sse2(in0+2*i, in1+2*i, out+4*i, numElems-i, scale);
+}
+
+TARGET("avx2")
+static void sc8ToSC16_avx2(const int8_t *in, int16_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m256i lo = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(in+i+0)));
+        const __m256i hi = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(in+i+16)));
+        _mm256_storeu_si256((__m256i *)(out+i+0), _mm256_slli_epi16(lo, SC8_SHIFT));
+        _mm256_storeu_si256((__m256i *)(out+i+16), _mm256_slli_epi16(hi, SC8_SHIFT));
+    }
+    sc8ToSC16_sse2(in+i, out+i, len-i);
+}
+
+TARGET("avx2")
+static void sc16ToSC8_avx2(const int16_t *in, int8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m256i lo = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i *)(in+i+0)), SC8_SHIFT);
+        const __m256i hi = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i *)(in+i+16)), SC8_SHIFT);
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), 0xd8);
+        _mm256_storeu_si256((__m256i *)(out+i), packed);
+    }
+    sc16ToSC8_sse2(in+i, out+i, len-i);
+}
+
+TARGET("avx2")
+static inline __m256i cvtSC8_avx2(const __m256 in, const __m256 scale)
+{
+    const __m256 clipped = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(in, scale), _mm256_set1_ps(SC8_MIN)), _mm256_set1_ps(SC8_MAX));
+    return _mm256_cvttps_epi32(clipped);
+}
+
+TARGET("avx2")
+static void cf32ToSC8_avx2(const float *in, int8_t *out, const size_t len, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m256i v0 = cvtSC8_avx2(_mm256_loadu_ps(in+i+0), s);
+        const __m256i v1 = cvtSC8_avx2(_mm256_loadu_ps(in+i+8), s);
+        const __m256i v2 = cvtSC8_avx2(_mm256_loadu_ps(in+i+16), s);
+        const __m256i v3 = cvtSC8_avx2(_mm256_loadu_ps(in+i+24), s);
+
+        //the packs work within 128-bit lanes, restore the sample order
+        const __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(v0, v1), _mm256_packs_epi32(v2, v3));
+        _mm256_storeu_si256((__m256i *)(out+i), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    cf32ToSC8_sse2(in+i, out+i, len-i, scale);
+}
+
+//each 128-bit lane unpacks 12 bytes, the byte shuffle does not cross lanes
+TARGET("avx2")
+static inline __m256i unpackSC12_avx2(const uint8_t *in)
+{
+    const __m256i order = _mm256_setr_epi8(
+        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m256i shift = _mm256_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1);
+    const __m128i lo = _mm_loadu_si128((const __m128i *)(in+0));
+    const __m128i hi = _mm_loadu_si128((const __m128i *)(in+12));
+    const __m256i v = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), order);
+    return _mm256_srai_epi16(_mm256_mullo_epi16(v, shift), 4);
+}
+
+TARGET("avx2")
+static void sc12ToSC16_avx2(const uint8_t *in, int16_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 16)
+    {
+        _mm256_storeu_si256((__m256i *)(out+i), unpackSC12_avx2(in+3*i/2));
+    }
+    sc12ToSC16_ssse3(in+3*i/2, out+i, len-i);
+}
+
+TARGET("avx2")
+static void sc12ToCF32_avx2(const uint8_t *in, float *out, const size_t len, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 16)
+    {
+        const __m256i v = unpackSC12_avx2(in+3*i/2);
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_ps(out+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    sc12ToCF32_ssse3(in+3*i/2, out+i, len-i, scale);
+}
+
+//group the 32-bit complex samples by channel: ch0 in the low lane, ch1 in the high lane
+TARGET("avx2")
+static inline __m256i splitChannels_avx2(const __m256i v)
+{
+    return _mm256_permute4x64_epi64(_mm256_shuffle_epi32(v, 0xd8), 0xd8);
+}
+
+TARGET("avx2")
+static void deinterleaveSC12ToSC16_avx2(const uint8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 4)
+    {
+        const __m256i v = splitChannels_avx2(unpackSC12_avx2(in+6*i));
+        _mm_storeu_si128((__m128i *)(out0+2*i), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i *)(out1+2*i), _mm256_extracti128_si256(v, 1));
+    }
+    deinterleaveSC12ToSC16_ssse3(in+6*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("avx2")
+static void deinterleaveSC12ToCF32_avx2(const uint8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 4)
+    {
+        const __m256i v = splitChannels_avx2(unpackSC12_avx2(in+6*i));
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_ps(out0+2*i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out1+2*i, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    deinterleaveSC12ToCF32_ssse3(in+6*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+TARGET("avx2")
+static void deinterleaveSC16_avx2(const int16_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const __m256i v0 = splitChannels_avx2(_mm256_loadu_si256((const __m256i *)(in+4*i+0)));
+        const __m256i v1 = splitChannels_avx2(_mm256_loadu_si256((const __m256i *)(in+4*i+16)));
+        _mm256_storeu_si256((__m256i *)(out0+2*i), _mm256_permute2x128_si256(v0, v1, 0x20));
+        _mm256_storeu_si256((__m256i *)(out1+2*i), _mm256_permute2x128_si256(v0, v1, 0x31));
+    }
+    deinterleaveSC16_sse2(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+TARGET("avx2")
+static void deinterleaveSC16ToCF32_avx2(const int16_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m256i v = splitChannels_avx2(_mm256_loadu_si256((const __m256i *)(in+4*i)));
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_ps(out0+2*i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out1+2*i, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    deinterleaveSC16ToCF32_sse2(in+4*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+TARGET("avx2")
+static void deinterleaveSC8ToCF32_avx2(const int8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const __m128i v = splitSC8_sse2(_mm_loadu_si128((const __m128i *)(in+4*i)));
+        const __m256i lo = _mm256_cvtepi8_epi32(v);
+        const __m256i hi = _mm256_cvtepi8_epi32(_mm_unpackhi_epi64(v, v));
+        _mm256_storeu_ps(out0+2*i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out1+2*i, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    deinterleaveSC8ToCF32_sse2(in+4*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+TARGET("avx2")
+static void interleaveSC16_avx2(const int16_t *in0, const int16_t *in1, int16_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        //the unpacks work within lanes, the permutes put the lanes back in sample order
+        const __m256i a = _mm256_loadu_si256((const __m256i *)(in0+2*i));
+        const __m256i b = _mm256_loadu_si256((const __m256i *)(in1+2*i));
+        const __m256i lo = _mm256_unpacklo_epi32(a, b);
+        const __m256i hi = _mm256_unpackhi_epi32(a, b);
+        _mm256_storeu_si256((__m256i *)(out+4*i+0), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(out+4*i+16), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleaveSC16_sse2(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+//each 128-bit lane packs into 12 bytes, the high lane is stored over the unused bytes of the low lane
+TARGET("avx2")
+static inline void storeSC12_avx2(uint8_t *out, const __m256i v)
+{
+    const __m256i order = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256i i = _mm256_and_si256(v, _mm256_set1_epi32(0x00000fff));
+    const __m256i q = _mm256_and_si256(_mm256_srli_epi32(v, 4), _mm256_set1_epi32(0x00fff000));
+    const __m256i packed = _mm256_shuffle_epi8(_mm256_or_si256(i, q), order);
+    _mm_storeu_si128((__m128i *)(out+0), _mm256_castsi256_si128(packed));
+    _mm_storeu_si128((__m128i *)(out+12), _mm256_extracti128_si256(packed, 1));
+}
+
+TARGET("avx2")
+static inline __m256i clipSC12_avx2(const __m256i v)
+{
+    return _mm256_min_epi16(_mm256_max_epi16(v, _mm256_set1_epi16(SC16_MIN)), _mm256_set1_epi16(SC16_MAX));
+}
+
+TARGET("avx2")
+static void sc16ToSC12_avx2(const int16_t *in, uint8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 16)
+    {
+        storeSC12_avx2(out+3*i/2, clipSC12_avx2(_mm256_loadu_si256((const __m256i *)(in+i))));
+    }
+    sc16ToSC12_ssse3(in+i, out+3*i/2, len-i);
+}
+
+TARGET("avx2")
+static void cf32ToSC12_avx2(const float *in, uint8_t *out, const size_t len, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 16)
+    {
+        const __m256i lo = cvtSC16_avx2(_mm256_loadu_ps(in+i+0), s);
+        const __m256i hi = cvtSC16_avx2(_mm256_loadu_ps(in+i+8), s);
+        storeSC12_avx2(out+3*i/2, _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+    }
+    cf32ToSC12_ssse3(in+i, out+3*i/2, len-i, scale);
+}
+
+TARGET("avx2")
+static void interleaveSC16ToSC12_avx2(const int16_t *in0, const int16_t *in1, uint8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 4)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(in0+2*i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(in1+2*i));
+        const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi32(a, b)), _mm_unpackhi_epi32(a, b), 1);
+        storeSC12_avx2(out+6*i, clipSC12_avx2(v));
+    }
+    interleaveSC16ToSC12_ssse3(in0+2*i, in1+2*i, out+6*i, numElems-i);
+}
+
+TARGET("avx2")
+static void interleaveCF32ToSC12_avx2(const float *in0, const float *in1, uint8_t *out, const size_t numElems, const float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 4)
+    {
+        const __m256d a = _mm256_castps_pd(_mm256_loadu_ps(in0+2*i));
+        const __m256d b = _mm256_castps_pd(_mm256_loadu_ps(in1+2*i));
+        const __m256d lo = _mm256_unpacklo_pd(a, b);
+        const __m256d hi = _mm256_unpackhi_pd(a, b);
+        const __m256i x0 = cvtSC16_avx2(_mm256_castpd_ps(_mm256_permute2f128_pd(lo, hi, 0x20)), s);
+        const __m256i x1 = cvtSC16_avx2(_mm256_castpd_ps(_mm256_permute2f128_pd(lo, hi, 0x31)), s);
+        storeSC12_avx2(out+6*i, _mm256_permute4x64_epi64(_mm256_packs_epi32(x0, x1), 0xd8));
+    }
+    interleaveCF32ToSC12_ssse3(in0+2*i, in1+2*i, out+6*i, numElems-i, scale);
+}
+
+/*******************************************************************
+ * AVX-512 kernels
+ ******************************************************************/
+
+//the conversions use the zero masked forms with every lane selected,
+//the plain forms start from an undefined register that gcc 12 warns about
+#define AVX512_ALL_LANES __mmask16(0xffff)
+
+TARGET("avx512f")
+static void sc16ToCF32_avx512(const int16_t *in, float *out, const size_t len, const float scale)
+{
+    const __m512 s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m512i lo = _mm512_maskz_cvtepi16_epi32(AVX512_ALL_LANES, _mm256_loadu_si256((const __m256i *)(in+i+0)));
+        const __m512i hi = _mm512_maskz_cvtepi16_epi32(AVX512_ALL_LANES, _mm256_loadu_si256((const __m256i *)(in+i+16)));
+        _mm512_storeu_ps(out+i+0, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(AVX512_ALL_LANES, lo), s));
+        _mm512_storeu_ps(out+i+16, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(AVX512_ALL_LANES, hi), s));
+    }
+    sc16ToCF32_avx2(in+i, out+i, len-i, scale);
+}
+
+TARGET("avx512f")
+static void sc8ToCF32_avx512(const int8_t *in, float *out, const size_t len, const float scale)
+{
+    const __m512 s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m512i lo = _mm512_maskz_cvtepi8_epi32(AVX512_ALL_LANES, _mm_loadu_si128((const __m128i *)(in+i+0)));
+        const __m512i hi = _mm512_maskz_cvtepi8_epi32(AVX512_ALL_LANES, _mm_loadu_si128((const __m128i *)(in+i+16)));
+        _mm512_storeu_ps(out+i+0, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(AVX512_ALL_LANES, lo), s));
+        _mm512_storeu_ps(out+i+16, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(AVX512_ALL_LANES, hi), s));
+    }
+    sc8ToCF32_avx2(in+i, out+i, len-i, scale);
+}
+
+#endif //CONVERT_X86
+
+/*******************************************************************
+ * NEON kernels
+ ******************************************************************/
+#ifdef CONVERT_NEON
+
+static void sc16ToCF32_neon(const int16_t *in, float *out, const size_t len, const float scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const int16x8_t v = vld1q_s16(in+i);
+        vst1q_f32(out+i+0, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out+i+4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    sc16ToCF32_generic(in+i, out+i, len-i, scale);
+}
+
+static void sc8ToCF32_neon(const int8_t *in, float *out, const size_t len, const float scale)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int8x16_t v = vld1q_s8(in+i);
+        const int16x8_t lo = vmovl_s8(vget_low_s8(v));
+        const int16x8_t hi = vmovl_s8(vget_high_s8(v));
+        vst1q_f32(out+i+0, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))), scale));
+        vst1q_f32(out+i+4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), scale));
+        vst1q_f32(out+i+8, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), scale));
+        vst1q_f32(out+i+12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), scale));
+    }
+    sc8ToCF32_generic(in+i, out+i, len-i, scale);
+}
+
+static inline int32x4_t cvtSC16_neon(const float32x4_t in, const float scale)
+{
+    //neon max passes NaN through, move it to the lower rail like the other kernels
+    const float32x4_t x = vmulq_n_f32(in, scale);
+    const float32x4_t num = vbslq_f32(vceqq_f32(x, x), x, vdupq_n_f32(SC16_MIN));
+    const float32x4_t clipped = vminq_f32(vmaxq_f32(num, vdupq_n_f32(SC16_MIN)), vdupq_n_f32(SC16_MAX));
+    return vcvtq_s32_f32(clipped);
+}
+
+static void cf32ToSC16_neon(const float *in, int16_t *out, const size_t len, const float scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const int16x4_t lo = vmovn_s32(cvtSC16_neon(vld1q_f32(in+i+0), scale));
+        const int16x4_t hi = vmovn_s32(cvtSC16_neon(vld1q_f32(in+i+4), scale));
+        vst1q_s16(out+i, vcombine_s16(lo, hi));
+    }
+    cf32ToSC16_generic(in+i, out+i, len-i, scale);
+}
+
+static void interleaveCF32ToSC16_neon(const float *in0, const float *in1, int16_t *out, const size_t numElems, const float scale)
+{
+    size_t i = 0;
+    for (; i + 2 <= numElems; i += 2)
+    {
+        const float32x4_t a = vld1q_f32(in0+2*i);
+        const float32x4_t b = vld1q_f32(in1+2*i);
+        const int16x4_t lo = vmovn_s32(cvtSC16_neon(vcombine_f32(vget_low_f32(a), vget_low_f32(b)), scale));
+        const int16x4_t hi = vmovn_s32(cvtSC16_neon(vcombine_f32(vget_high_f32(a), vget_high_f32(b)), scale));
+        vst1q_s16(out+4*i, vcombine_s16(lo, hi));
+    }
+    interleaveCF32ToSC16_generic(in0+2*i, in1+2*i, out+4*i, numElems-i, scale);
+}
+
+static void sc8ToSC16_neon(const int8_t *in, int16_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int8x16_t v = vld1q_s8(in+i);
+        vst1q_s16(out+i+0, vshll_n_s8(vget_low_s8(v), SC8_SHIFT));
+        vst1q_s16(out+i+8, vshll_n_s8(vget_high_s8(v), SC8_SHIFT));
+    }
+    sc8ToSC16_generic(in+i, out+i, len-i);
+}
+
+static void sc16ToSC8_neon(const int16_t *in, int8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int8x8_t lo = vqshrn_n_s16(vld1q_s16(in+i+0), SC8_SHIFT);
+        const int8x8_t hi = vqshrn_n_s16(vld1q_s16(in+i+8), SC8_SHIFT);
+        vst1q_s8(out+i, vcombine_s8(lo, hi));
+    }
+    sc16ToSC8_generic(in+i, out+i, len-i);
+}
+
+static inline int32x4_t cvtSC8_neon(const float32x4_t in, const float scale)
+{
+    //neon max passes NaN through, move it to the lower rail like the other kernels
+    const float32x4_t x = vmulq_n_f32(in, scale);
+    const float32x4_t num = vbslq_f32(vceqq_f32(x, x), x, vdupq_n_f32(SC8_MIN));
+    const float32x4_t clipped = vminq_f32(vmaxq_f32(num, vdupq_n_f32(SC8_MIN)), vdupq_n_f32(SC8_MAX));
+    return vcvtq_s32_f32(clipped);
+}
+
+static void cf32ToSC8_neon(const float *in, int8_t *out, const size_t len, const float scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const int16x4_t lo = vmovn_s32(cvtSC8_neon(vld1q_f32(in+i+0), scale));
+        const int16x4_t hi = vmovn_s32(cvtSC8_neon(vld1q_f32(in+i+4), scale));
+        vst1_s8(out+i, vmovn_s16(vcombine_s16(lo, hi)));
+    }
+    cf32ToSC8_generic(in+i, out+i, len-i, scale);
+}
+
+//vld3 splits the 3 bytes of 8 complex samples into separate registers
+static inline int16x8x2_t unpackSC12_neon(const uint8_t *in)
+{
+    const uint8x8x3_t v = vld3_u8(in);
+    const int16x8_t b0 = vreinterpretq_s16_u16(vmovl_u8(v.val[0]));
+    const int16x8_t b1 = vreinterpretq_s16_u16(vmovl_u8(v.val[1]));
+    const int16x8_t b2 = vreinterpretq_s16_u16(vmovl_u8(v.val[2]));
+    int16x8x2_t iq;
+    iq.val[0] = vshrq_n_s16(vshlq_n_s16(vorrq_s16(b0, vshlq_n_s16(b1, 8)), 4), 4);
+    iq.val[1] = vshrq_n_s16(vorrq_s16(b1, vshlq_n_s16(b2, 8)), 4);
+    return iq;
+}
+
+static inline float32x4x2_t cvtCF32_neon(const int16x4_t i, const int16x4_t q, const float scale)
+{
+    float32x4x2_t out;
+    out.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(i)), scale);
+    out.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(q)), scale);
+    return out;
+}
+
+static void sc12ToSC16_neon(const uint8_t *in, int16_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        vst2q_s16(out+i, unpackSC12_neon(in+3*i/2));
+    }
+    sc12ToSC16_generic(in+3*i/2, out+i, len-i);
+}
+
+static void sc12ToCF32_neon(const uint8_t *in, float *out, const size_t len, const float scale)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int16x8x2_t iq = unpackSC12_neon(in+3*i/2);
+        vst2q_f32(out+i+0, cvtCF32_neon(vget_low_s16(iq.val[0]), vget_low_s16(iq.val[1]), scale));
+        vst2q_f32(out+i+8, cvtCF32_neon(vget_high_s16(iq.val[0]), vget_high_s16(iq.val[1]), scale));
+    }
+    sc12ToCF32_generic(in+3*i/2, out+i, len-i, scale);
+}
+
+static void deinterleaveSC12ToSC16_neon(const uint8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        //even samples belong to ch0: [I0 I2 I4 I6 Q0 Q2 Q4 Q6], odd samples to ch1
+        const int16x8x2_t iq = unpackSC12_neon(in+6*i);
+        const int16x8x2_t ch = vuzpq_s16(iq.val[0], iq.val[1]);
+        int16x4x2_t ch0, ch1;
+        ch0.val[0] = vget_low_s16(ch.val[0]);
+        ch0.val[1] = vget_high_s16(ch.val[0]);
+        ch1.val[0] = vget_low_s16(ch.val[1]);
+        ch1.val[1] = vget_high_s16(ch.val[1]);
+        vst2_s16(out0+2*i, ch0);
+        vst2_s16(out1+2*i, ch1);
+    }
+    deinterleaveSC12ToSC16_generic(in+6*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+static void deinterleaveSC12ToCF32_neon(const uint8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const int16x8x2_t iq = unpackSC12_neon(in+6*i);
+        const int16x8x2_t ch = vuzpq_s16(iq.val[0], iq.val[1]);
+        vst2q_f32(out0+2*i, cvtCF32_neon(vget_low_s16(ch.val[0]), vget_high_s16(ch.val[0]), scale));
+        vst2q_f32(out1+2*i, cvtCF32_neon(vget_low_s16(ch.val[1]), vget_high_s16(ch.val[1]), scale));
+    }
+    deinterleaveSC12ToCF32_generic(in+6*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+//vst3 merges the 3 byte planes of 8 complex samples, the inputs must be within the 12-bit range
+static inline void packSC12_neon(uint8_t *out, const int16x8_t i, const int16x8_t q)
+{
+    const uint16x8_t iu = vreinterpretq_u16_s16(i);
+    const uint16x8_t qu = vreinterpretq_u16_s16(q);
+    uint8x8x3_t v;
+    v.val[0] = vmovn_u16(iu);
+    v.val[1] = vmovn_u16(vorrq_u16(vandq_u16(vshrq_n_u16(iu, 8), vdupq_n_u16(0xf)), vshlq_n_u16(qu, 4)));
+    v.val[2] = vmovn_u16(vshrq_n_u16(qu, 4));
+    vst3_u8(out, v);
+}
+
+static inline int16x8_t clipSC12_neon(const int16x8_t v)
+{
+    return vminq_s16(vmaxq_s16(v, vdupq_n_s16(SC16_MIN)), vdupq_n_s16(SC16_MAX));
+}
+
+static inline int16x8_t cvtSC12_neon(const float32x4_t lo, const float32x4_t hi, const float scale)
+{
+    return vcombine_s16(vmovn_s32(cvtSC16_neon(lo, scale)), vmovn_s32(cvtSC16_neon(hi, scale)));
+}
+
+static void sc16ToSC12_neon(const int16_t *in, uint8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int16x8x2_t iq = vld2q_s16(in+i);
+        packSC12_neon(out+3*i/2, clipSC12_neon(iq.val[0]), clipSC12_neon(iq.val[1]));
+    }
+    sc16ToSC12_generic(in+i, out+3*i/2, len-i);
+}
+
+static void cf32ToSC12_neon(const float *in, uint8_t *out, const size_t len, const float scale)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const float32x4x2_t lo = vld2q_f32(in+i+0);
+        const float32x4x2_t hi = vld2q_f32(in+i+8);
+        packSC12_neon(out+3*i/2, cvtSC12_neon(lo.val[0], hi.val[0], scale), cvtSC12_neon(lo.val[1], hi.val[1], scale));
+    }
+    cf32ToSC12_generic(in+i, out+3*i/2, len-i, scale);
+}
+
+static void interleaveSC16ToSC12_neon(const int16_t *in0, const int16_t *in1, uint8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        //alternate the samples between the channels
+        const int16x4x2_t a = vld2_s16(in0+2*i);
+        const int16x4x2_t b = vld2_s16(in1+2*i);
+        const int16x4x2_t iv = vzip_s16(a.val[0], b.val[0]);
+        const int16x4x2_t qv = vzip_s16(a.val[1], b.val[1]);
+        const int16x8_t iw = clipSC12_neon(vcombine_s16(iv.val[0], iv.val[1]));
+        const int16x8_t qw = clipSC12_neon(vcombine_s16(qv.val[0], qv.val[1]));
+        packSC12_neon(out+6*i, iw, qw);
+    }
+    interleaveSC16ToSC12_generic(in0+2*i, in1+2*i, out+6*i, numElems-i);
+}
+
+static void interleaveCF32ToSC12_neon(const float *in0, const float *in1, uint8_t *out, const size_t numElems, const float scale)
+{
+    size_t i = 0;
+    for (; i + 4 <= numElems; i += 4)
+    {
+        const float32x4x2_t a = vld2q_f32(in0+2*i);
+        const float32x4x2_t b = vld2q_f32(in1+2*i);
+        const float32x4x2_t iv = vzipq_f32(a.val[0], b.val[0]);
+        const float32x4x2_t qv = vzipq_f32(a.val[1], b.val[1]);
+        packSC12_neon(out+6*i, cvtSC12_neon(iv.val[0], iv.val[1], scale), cvtSC12_neon(qv.val[0], qv.val[1], scale));
+    }
+    interleaveCF32ToSC12_generic(in0+2*i, in1+2*i, out+6*i, numElems-i, scale);
+}
+
+static void deinterleaveSC12_neon(const uint8_t *in, uint8_t *out0, uint8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        //vld3 splits the bytes of 16 samples, even samples belong to ch0 and odd samples to ch1
+        const uint8x16x3_t v = vld3q_u8(in+6*i);
+        uint8x8x3_t ch0, ch1;
+        for (size_t j = 0; j < 3; j++)
+        {
+            const uint8x8x2_t ch = vuzp_u8(vget_low_u8(v.val[j]), vget_high_u8(v.val[j]));
+            ch0.val[j] = ch.val[0];
+            ch1.val[j] = ch.val[1];
+        }
+        vst3_u8(out0+3*i, ch0);
+        vst3_u8(out1+3*i, ch1);
+    }
+    deinterleaveSC12_generic(in+6*i, out0+3*i, out1+3*i, numElems-i);
+}
+
+static void interleaveSC12_neon(const uint8_t *in0, const uint8_t *in1, uint8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const uint8x8x3_t a = vld3_u8(in0+3*i);
+        const uint8x8x3_t b = vld3_u8(in1+3*i);
+        uint8x16x3_t v;
+        for (size_t j = 0; j < 3; j++)
+        {
+            const uint8x8x2_t z = vzip_u8(a.val[j], b.val[j]);
+            v.val[j] = vcombine_u8(z.val[0], z.val[1]);
+        }
+        vst3q_u8(out+6*i, v);
+    }
+    interleaveSC12_generic(in0+3*i, in1+3*i, out+6*i, numElems-i);
+}
+
+static void sc12ToSC8_neon(const uint8_t *in, int8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int16x8x2_t iq = unpackSC12_neon(in+3*i/2);
+        int8x8x2_t v;
+        v.val[0] = vqshrn_n_s16(iq.val[0], SC8_SHIFT);
+        v.val[1] = vqshrn_n_s16(iq.val[1], SC8_SHIFT);
+        vst2_s8(out+i, v);
+    }
+    sc12ToSC8_generic(in+3*i/2, out+i, len-i);
+}
+
+static void sc8ToSC12_neon(const int8_t *in, uint8_t *out, const size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        const int8x8x2_t iq = vld2_s8(in+i);
+        packSC12_neon(out+3*i/2, vshll_n_s8(iq.val[0], SC8_SHIFT), vshll_n_s8(iq.val[1], SC8_SHIFT));
+    }
+    sc8ToSC12_generic(in+i, out+3*i/2, len-i);
+}
+
+//vld4 splits the two channel wire samples into I and Q of each channel
+
+static void deinterleaveSC16_neon(const int16_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int16x8x4_t v = vld4q_s16(in+4*i);
+        int16x8x2_t ch0, ch1;
+        ch0.val[0] = v.val[0];
+        ch0.val[1] = v.val[1];
+        ch1.val[0] = v.val[2];
+        ch1.val[1] = v.val[3];
+        vst2q_s16(out0+2*i, ch0);
+        vst2q_s16(out1+2*i, ch1);
+    }
+    deinterleaveSC16_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+static void deinterleaveSC16ToCF32_neon(const int16_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int16x8x4_t v = vld4q_s16(in+4*i);
+        vst2q_f32(out0+2*i+0, cvtCF32_neon(vget_low_s16(v.val[0]), vget_low_s16(v.val[1]), scale));
+        vst2q_f32(out0+2*i+8, cvtCF32_neon(vget_high_s16(v.val[0]), vget_high_s16(v.val[1]), scale));
+        vst2q_f32(out1+2*i+0, cvtCF32_neon(vget_low_s16(v.val[2]), vget_low_s16(v.val[3]), scale));
+        vst2q_f32(out1+2*i+8, cvtCF32_neon(vget_high_s16(v.val[2]), vget_high_s16(v.val[3]), scale));
+    }
+    deinterleaveSC16ToCF32_generic(in+4*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+static void deinterleaveSC16ToSC8_neon(const int16_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int16x8x4_t v = vld4q_s16(in+4*i);
+        int8x8x2_t ch0, ch1;
+        ch0.val[0] = vqshrn_n_s16(v.val[0], SC8_SHIFT);
+        ch0.val[1] = vqshrn_n_s16(v.val[1], SC8_SHIFT);
+        ch1.val[0] = vqshrn_n_s16(v.val[2], SC8_SHIFT);
+        ch1.val[1] = vqshrn_n_s16(v.val[3], SC8_SHIFT);
+        vst2_s8(out0+2*i, ch0);
+        vst2_s8(out1+2*i, ch1);
+    }
+    deinterleaveSC16ToSC8_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+static void deinterleaveSC8_neon(const int8_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int8x8x4_t v = vld4_s8(in+4*i);
+        int8x8x2_t ch0, ch1;
+        ch0.val[0] = v.val[0];
+        ch0.val[1] = v.val[1];
+        ch1.val[0] = v.val[2];
+        ch1.val[1] = v.val[3];
+        vst2_s8(out0+2*i, ch0);
+        vst2_s8(out1+2*i, ch1);
+    }
+    deinterleaveSC8_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+static void deinterleaveSC8ToCF32_neon(const int8_t *in, float *out0, float *out1, const size_t numElems, const float scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int8x8x4_t v = vld4_s8(in+4*i);
+        const int16x8_t i0 = vmovl_s8(v.val[0]);
+        const int16x8_t q0 = vmovl_s8(v.val[1]);
+        const int16x8_t i1 = vmovl_s8(v.val[2]);
+        const int16x8_t q1 = vmovl_s8(v.val[3]);
+        vst2q_f32(out0+2*i+0, cvtCF32_neon(vget_low_s16(i0), vget_low_s16(q0), scale));
+        vst2q_f32(out0+2*i+8, cvtCF32_neon(vget_high_s16(i0), vget_high_s16(q0), scale));
+        vst2q_f32(out1+2*i+0, cvtCF32_neon(vget_low_s16(i1), vget_low_s16(q1), scale));
+        vst2q_f32(out1+2*i+8, cvtCF32_neon(vget_high_s16(i1), vget_high_s16(q1), scale));
+    }
+    deinterleaveSC8ToCF32_generic(in+4*i, out0+2*i, out1+2*i, numElems-i, scale);
+}
+
+static void deinterleaveSC8ToSC16_neon(const int8_t *in, int16_t *out0, int16_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int8x8x4_t v = vld4_s8(in+4*i);
+        int16x8x2_t ch0, ch1;
+        ch0.val[0] = vshll_n_s8(v.val[0], SC8_SHIFT);
+        ch0.val[1] = vshll_n_s8(v.val[1], SC8_SHIFT);
+        ch1.val[0] = vshll_n_s8(v.val[2], SC8_SHIFT);
+        ch1.val[1] = vshll_n_s8(v.val[3], SC8_SHIFT);
+        vst2q_s16(out0+2*i, ch0);
+        vst2q_s16(out1+2*i, ch1);
+    }
+    deinterleaveSC8ToSC16_generic(in+4*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+static void deinterleaveSC12ToSC8_neon(const uint8_t *in, int8_t *out0, int8_t *out1, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        //even samples belong to ch0 and odd samples to ch1
+        const int16x8x2_t a = unpackSC12_neon(in+6*i+0);
+        const int16x8x2_t b = unpackSC12_neon(in+6*i+24);
+        const int8x8x2_t iv = vuzp_s8(vqshrn_n_s16(a.val[0], SC8_SHIFT), vqshrn_n_s16(b.val[0], SC8_SHIFT));
+        const int8x8x2_t qv = vuzp_s8(vqshrn_n_s16(a.val[1], SC8_SHIFT), vqshrn_n_s16(b.val[1], SC8_SHIFT));
+        int8x8x2_t ch0, ch1;
+        ch0.val[0] = iv.val[0];
+        ch0.val[1] = qv.val[0];
+        ch1.val[0] = iv.val[1];
+        ch1.val[1] = qv.val[1];
+        vst2_s8(out0+2*i, ch0);
+        vst2_s8(out1+2*i, ch1);
+    }
+    deinterleaveSC12ToSC8_generic(in+6*i, out0+2*i, out1+2*i, numElems-i);
+}
+
+//vst4 merges I and Q of each channel into the two channel wire samples
+
+static void interleaveSC16_neon(const int16_t *in0, const int16_t *in1, int16_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int16x8x2_t a = vld2q_s16(in0+2*i);
+        const int16x8x2_t b = vld2q_s16(in1+2*i);
+        int16x8x4_t v;
+        v.val[0] = a.val[0];
+        v.val[1] = a.val[1];
+        v.val[2] = b.val[0];
+        v.val[3] = b.val[1];
+        vst4q_s16(out+4*i, v);
+    }
+    interleaveSC16_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+static void interleaveSC8_neon(const int8_t *in0, const int8_t *in1, int8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int8x8x2_t a = vld2_s8(in0+2*i);
+        const int8x8x2_t b = vld2_s8(in1+2*i);
+        int8x8x4_t v;
+        v.val[0] = a.val[0];
+        v.val[1] = a.val[1];
+        v.val[2] = b.val[0];
+        v.val[3] = b.val[1];
+        vst4_s8(out+4*i, v);
+    }
+    interleaveSC8_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+static void interleaveSC16ToSC8_neon(const int16_t *in0, const int16_t *in1, int8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int16x8x2_t a = vld2q_s16(in0+2*i);
+        const int16x8x2_t b = vld2q_s16(in1+2*i);
+        int8x8x4_t v;
+        v.val[0] = vqshrn_n_s16(a.val[0], SC8_SHIFT);
+        v.val[1] = vqshrn_n_s16(a.val[1], SC8_SHIFT);
+        v.val[2] = vqshrn_n_s16(b.val[0], SC8_SHIFT);
+        v.val[3] = vqshrn_n_s16(b.val[1], SC8_SHIFT);
+        vst4_s8(out+4*i, v);
+    }
+    interleaveSC16ToSC8_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+static void interleaveSC8ToSC16_neon(const int8_t *in0, const int8_t *in1, int16_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const int8x8x2_t a = vld2_s8(in0+2*i);
+        const int8x8x2_t b = vld2_s8(in1+2*i);
+        int16x8x4_t v;
+        v.val[0] = vshll_n_s8(a.val[0], SC8_SHIFT);
+        v.val[1] = vshll_n_s8(a.val[1], SC8_SHIFT);
+        v.val[2] = vshll_n_s8(b.val[0], SC8_SHIFT);
+        v.val[3] = vshll_n_s8(b.val[1], SC8_SHIFT);
+        vst4q_s16(out+4*i, v);
+    }
+    interleaveSC8ToSC16_generic(in0+2*i, in1+2*i, out+4*i, numElems-i);
+}
+
+static inline int8x8_t cvtSC8x8_neon(const float32x4_t lo, const float32x4_t hi, const float scale)
+{
+    return vmovn_s16(vcombine_s16(vmovn_s32(cvtSC8_neon(lo, scale)), vmovn_s32(cvtSC8_neon(hi, scale))));
+}
+
+static void interleaveCF32ToSC8_neon(const float *in0, const float *in1, int8_t *out, const size_t numElems, const float scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        const float32x4x2_t a0 = vld2q_f32(in0+2*i+0);
+        const float32x4x2_t a1 = vld2q_f32(in0+2*i+8);
+        const float32x4x2_t b0 = vld2q_f32(in1+2*i+0);
+        const float32x4x2_t b1 = vld2q_f32(in1+2*i+8);
+        int8x8x4_t v;
+        v.val[0] = cvtSC8x8_neon(a0.val[0], a1.val[0], scale);
+        v.val[1] = cvtSC8x8_neon(a0.val[1], a1.val[1], scale);
+        v.val[2] = cvtSC8x8_neon(b0.val[0], b1.val[0], scale);
+        v.val[3] = cvtSC8x8_neon(b0.val[1], b1.val[1], scale);
+        vst4_s8(out+4*i, v);
+    }
+    interleaveCF32ToSC8_generic(in0+2*i, in1+2*i, out+4*i, numElems-i, scale);
+}
+
+static void interleaveSC8ToSC12_neon(const int8_t *in0, const int8_t *in1, uint8_t *out, const size_t numElems)
+{
+    size_t i = 0;
+    for (; i + 8 <= numElems; i += 8)
+    {
+        //alternate the samples between the channels
+        const int8x8x2_t a = vld2_s8(in0+2*i);
+        const int8x8x2_t b = vld2_s8(in1+2*i);
+        const int8x8x2_t iv = vzip_s8(a.val[0], b.val[0]);
+        const int8x8x2_t qv = vzip_s8(a.val[1], b.val[1]);
+        packSC12_neon(out+6*i+0, vshll_n_s8(iv.val[0], SC8_SHIFT), vshll_n_s8(qv.val[0], SC8_SHIFT));
+        packSC12_neon(out+6*i+24, vshll_n_s8(iv.val[1], SC8_SHIFT), vshll_n_s8(qv.val[1], SC8_SHIFT));
+    }
+    interleaveSC8ToSC12_generic(in0+2*i, in1+2*i, out+6*i, numElems-i);
+}
+
+#endif //CONVERT_NEON
+
+/*******************************************************************
+ * Runtime selection
+ ******************************************************************/
+
+static ConvertKernels selectConvertKernels(void)
+{
+    ConvertKernels k;
+    k.isa = "generic";
+    k.sc16ToCF32 = &sc16ToCF32_generic;
+    k.sc8ToCF32 = &sc8ToCF32_generic;
+    k.cf32ToSC16 = &cf32ToSC16_generic;
+    k.cf32ToSC8 = &cf32ToSC8_generic;
+    k.sc8ToSC16 = &sc8ToSC16_generic;
+    k.sc16ToSC8 = &sc16ToSC8_generic;
+    k.sc12ToSC16 = &sc12ToSC16_generic;
+    k.sc12ToCF32 = &sc12ToCF32_generic;
+    k.sc12ToSC8 = &sc12ToSC8_generic;
+    k.sc8ToSC12 = &sc8ToSC12_generic;
+    k.sc16ToSC12 = &sc16ToSC12_generic;
+    k.cf32ToSC12 = &cf32ToSC12_generic;
+    k.deinterleaveSC16 = &deinterleaveSC16_generic;
+    k.deinterleaveSC8 = &deinterleaveSC8_generic;
+    k.deinterleaveSC12 = &deinterleaveSC12_generic;
+    k.deinterleaveSC16ToCF32 = &deinterleaveSC16ToCF32_generic;
+    k.deinterleaveSC8ToCF32 = &deinterleaveSC8ToCF32_generic;
+    k.deinterleaveSC16ToSC8 = &deinterleaveSC16ToSC8_generic;
+    k.deinterleaveSC8ToSC16 = &deinterleaveSC8ToSC16_generic;
+    k.deinterleaveSC12ToSC16 = &deinterleaveSC12ToSC16_generic;
+    k.deinterleaveSC12ToCF32 = &deinterleaveSC12ToCF32_generic;
+    k.deinterleaveSC12ToSC8 = &deinterleaveSC12ToSC8_generic;
+    k.interleaveSC16 = &interleaveSC16_generic;
+    k.interleaveSC8 = &interleaveSC8_generic;
+    k.interleaveSC12 = &interleaveSC12_generic;
+    k.interleaveCF32ToSC16 = &interleaveCF32ToSC16_generic;
+    k.interleaveCF32ToSC8 = &interleaveCF32ToSC8_generic;
+    k.interleaveSC16ToSC8 = &interleaveSC16ToSC8_generic;
+    k.interleaveSC8ToSC16 = &interleaveSC8ToSC16_generic;
+    k.interleaveSC16ToSC12 = &interleaveSC16ToSC12_generic;
+    k.interleaveCF32ToSC12 = &interleaveCF32ToSC12_generic;
+    k.interleaveSC8ToSC12 = &interleaveSC8ToSC12_generic;
+
+    #ifdef CONVERT_NEON
+    k.isa = "neon";
+    k.sc16ToCF32 = &sc16ToCF32_neon;
+    k.sc8ToCF32 = &sc8ToCF32_neon;
+    k.cf32ToSC16 = &cf32ToSC16_neon;
+    k.cf32ToSC8 = &cf32ToSC8_neon;
+    k.sc8ToSC16 = &sc8ToSC16_neon;
+    k.sc16ToSC8 = &sc16ToSC8_neon;
+    k.sc12ToSC16 = &sc12ToSC16_neon;
+    k.sc12ToCF32 = &sc12ToCF32_neon;
+    k.deinterleaveSC12ToSC16 = &deinterleaveSC12ToSC16_neon;
+    k.deinterleaveSC12ToCF32 = &deinterleaveSC12ToCF32_neon;
+    k.sc16ToSC12 = &sc16ToSC12_neon;
+    k.cf32ToSC12 = &cf32ToSC12_neon;
+    k.interleaveSC16ToSC12 = &interleaveSC16ToSC12_neon;
+    k.interleaveCF32ToSC12 = &interleaveCF32ToSC12_neon;
+    k.interleaveCF32ToSC16 = &interleaveCF32ToSC16_neon;
+    k.sc12ToSC8 = &sc12ToSC8_neon;
+    k.deinterleaveSC12 = &deinterleaveSC12_neon;
+    k.interleaveSC12 = &interleaveSC12_neon;
+    k.sc8ToSC12 = &sc8ToSC12_neon;
+    k.deinterleaveSC16 = &deinterleaveSC16_neon;
+    k.deinterleaveSC8 = &deinterleaveSC8_neon;
+    k.deinterleaveSC16ToCF32 = &deinterleaveSC16ToCF32_neon;
+    k.deinterleaveSC8ToCF32 = &deinterleaveSC8ToCF32_neon;
+    k.deinterleaveSC16ToSC8 = &deinterleaveSC16ToSC8_neon;
+    k.deinterleaveSC8ToSC16 = &deinterleaveSC8ToSC16_neon;
+    k.deinterleaveSC12ToSC8 = &deinterleaveSC12ToSC8_neon;
+    k.interleaveSC16 = &interleaveSC16_neon;
+    k.interleaveSC8 = &interleaveSC8_neon;
+    k.interleaveCF32ToSC8 = &interleaveCF32ToSC8_neon;
+    k.interleaveSC16ToSC8 = &interleaveSC16ToSC8_neon;
+    k.interleaveSC8ToSC16 = &interleaveSC8ToSC16_neon;
+    k.interleaveSC8ToSC12 = &interleaveSC8ToSC12_neon;
+    #endif
+
+    #ifdef CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+    {
+        k.isa = "sse2";
+        k.sc16ToCF32 = &sc16ToCF32_sse2;
+        k.sc8ToCF32 = &sc8ToCF32_sse2;
+        k.cf32ToSC16 = &cf32ToSC16_sse2;
+        k.cf32ToSC8 = &cf32ToSC8_sse2;
+        k.sc8ToSC16 = &sc8ToSC16_sse2;
+        k.sc16ToSC8 = &sc16ToSC8_sse2;
+        k.interleaveCF32ToSC16 = &interleaveCF32ToSC16_sse2;
+        k.deinterleaveSC16 = &deinterleaveSC16_sse2;
+        k.deinterleaveSC8 = &deinterleaveSC8_sse2;
+        k.deinterleaveSC16ToCF32 = &deinterleaveSC16ToCF32_sse2;
+        k.deinterleaveSC8ToCF32 = &deinterleaveSC8ToCF32_sse2;
+        k.deinterleaveSC16ToSC8 = &deinterleaveSC16ToSC8_sse2;
+        k.deinterleaveSC8ToSC16 = &deinterleaveSC8ToSC16_sse2;
+        k.interleaveSC16 = &interleaveSC16_sse2;
+        k.interleaveSC8 = &interleaveSC8_sse2;
+        k.interleaveCF32ToSC8 = &interleaveCF32ToSC8_sse2;
+        k.interleaveSC16ToSC8 = &interleaveSC16ToSC8_sse2;
+        k.interleaveSC8ToSC16 = &interleaveSC8ToSC16_sse2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        k.isa = "ssse3";
+        k.sc12ToSC16 = &sc12ToSC16_ssse3;
+        k.sc12ToCF32 = &sc12ToCF32_ssse3;
+        k.deinterleaveSC12ToSC16 = &deinterleaveSC12ToSC16_ssse3;
+        k.deinterleaveSC12ToCF32 = &deinterleaveSC12ToCF32_ssse3;
+        k.sc16ToSC12 = &sc16ToSC12_ssse3;
+        k.cf32ToSC12 = &cf32ToSC12_ssse3;
+        k.interleaveSC16ToSC12 = &interleaveSC16ToSC12_ssse3;
+        k.interleaveCF32ToSC12 = &interleaveCF32ToSC12_ssse3;
+        k.sc12ToSC8 = &sc12ToSC8_ssse3;
+        k.deinterleaveSC12 = &deinterleaveSC12_ssse3;
+        k.interleaveSC12 = &interleaveSC12_ssse3;
+        k.sc8ToSC12 = &sc8ToSC12_ssse3;
+        k.deinterleaveSC12ToSC8 = &deinterleaveSC12ToSC8_ssse3;
+        k.interleaveSC8ToSC12 = &interleaveSC8ToSC12_ssse3;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        k.isa = "avx2";
+        k.sc16ToCF32 = &sc16ToCF32_avx2;
+        k.sc8ToCF32 = &sc8ToCF32_avx2;
+        k.cf32ToSC16 = &cf32ToSC16_avx2;
+        k.cf32ToSC8 = &cf32ToSC8_avx2;
+        k.sc8ToSC16 = &sc8ToSC16_avx2;
+        k.sc16ToSC8 = &sc16ToSC8_avx2;
+        k.sc12ToSC16 = &sc12ToSC16_avx2;
+        k.sc12ToCF32 = &sc12ToCF32_avx2;
+        k.deinterleaveSC12ToSC16 = &deinterleaveSC12ToSC16_avx2;
+        k.deinterleaveSC12ToCF32 = &deinterleaveSC12ToCF32_avx2;
+        k.sc16ToSC12 = &sc16ToSC12_avx2;
+        k.cf32ToSC12 = &cf32ToSC12_avx2;
+        k.interleaveSC16ToSC12 = &interleaveSC16ToSC12_avx2;
+        k.interleaveCF32ToSC12 = &interleaveCF32ToSC12_avx2;
+        k.interleaveCF32ToSC16 = &interleaveCF32ToSC16_avx2;
+        k.deinterleaveSC16 = &deinterleaveSC16_avx2;
+        k.deinterleaveSC16ToCF32 = &deinterleaveSC16ToCF32_avx2;
+        k.deinterleaveSC8ToCF32 = &deinterleaveSC8ToCF32_avx2;
+        k.interleaveSC16 = &interleaveSC16_avx2;
+    }
+    //kernels without an avx512 implementation remain on avx2
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        k.isa = "avx512";
+        k.sc16ToCF32 = &sc16ToCF32_avx512;
+        k.sc8ToCF32 = &sc8ToCF32_avx512;
+    }
+    #endif
+
+    return k;
+}
+
+const ConvertKernels &getConvertKernels(void)
+{
+    static const ConvertKernels kernels(selectConvertKernels());
+    return kernels;
+}
+
+/*******************************************************************
+ * Stream converter table
+ ******************************************************************/
+
+//each entry is specialized on the kernel that it wraps,
+//the kernel itself is selected by the CPU features at runtime
+
+template <typename In, typename Out, void (*ConvertKernels::*kernel)(const In *, Out *, const size_t)>
+static void toHost1(const void *input, void * const *buffs, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const In *)input, (Out *)buffs[0], 2 * numElems);
+}
+
+template <typename In, void (*ConvertKernels::*kernel)(const In *, float *, const size_t, const float), int fullScale>
+static void toHostScaled1(const void *input, void * const *buffs, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const In *)input, (float *)buffs[0], 2 * numElems, 1.0f/fullScale);
+}
+
+template <typename In, typename Out, void (*ConvertKernels::*kernel)(const In *, Out *, Out *, const size_t)>
+static void toHost2(const void *input, void * const *buffs, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const In *)input, (Out *)buffs[0], (Out *)buffs[1], numElems);
+}
+
+template <typename In, void (*ConvertKernels::*kernel)(const In *, float *, float *, const size_t, const float), int fullScale>
+static void toHostScaled2(const void *input, void * const *buffs, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const In *)input, (float *)buffs[0], (float *)buffs[1], numElems, 1.0f/fullScale);
+}
+
+template <typename In, typename Out, void (*ConvertKernels::*kernel)(const In *, Out *, const size_t)>
+static void toWire1(const void * const *buffs, void *output, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const In *)buffs[0], (Out *)output, 2 * numElems);
+}
+
+template <typename Out, void (*ConvertKernels::*kernel)(const float *, Out *, const size_t, const float), int fullScale>
+static void toWireScaled1(const void * const *buffs, void *output, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const float *)buffs[0], (Out *)output, 2 * numElems, float(fullScale));
+}
+
+template <typename In, typename Out, void (*ConvertKernels::*kernel)(const In *, const In *, Out *, const size_t)>
+static void toWire2(const void * const *buffs, void *output, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const In *)buffs[0], (const In *)buffs[1], (Out *)output, numElems);
+}
+
+template <typename Out, void (*ConvertKernels::*kernel)(const float *, const float *, Out *, const size_t, const float), int fullScale>
+static void toWireScaled2(const void * const *buffs, void *output, const size_t numElems)
+{
+    (getConvertKernels().*kernel)((const float *)buffs[0], (const float *)buffs[1], (Out *)output, numElems, float(fullScale));
+}
+
+//the host format matches the wire, the callers use the buffer in place when they can
+template <size_t sampleSize>
+static void copyToHost(const void *input, void * const *buffs, const size_t numElems)
+{
+    std::memcpy(buffs[0], input, numElems * sampleSize);
+}
+
+template <size_t sampleSize>
+static void copyToWire(const void * const *buffs, void *output, const size_t numElems)
+{
+    std::memcpy(output, buffs[0], numElems * sampleSize);
+}
+
+struct StreamConverterEntry
+{
+    bool isTx;
+    ConvertWireFormat wire;
+    const char *hostFormat;
+    size_t numChans;
+    StreamConverter converter;
+};
+
+static const StreamConverterEntry streamConverters[] = {
+    //receive, one channel
+    {false, CONVERT_WIRE_SC16, SOAPY_SDR_CS16, 1, {&copyToHost<4>, nullptr, true}},
+    {false, CONVERT_WIRE_SC16, SOAPY_SDR_CS8, 1, {&toHost1<int16_t, int8_t, &ConvertKernels::sc16ToSC8>, nullptr, false}},
+    {false, CONVERT_WIRE_SC16, SOAPY_SDR_CF32, 1, {&toHostScaled1<int16_t, &ConvertKernels::sc16ToCF32, 2048>, nullptr, false}},
+    {false, CONVERT_WIRE_SC8, SOAPY_SDR_CS16, 1, {&toHost1<int8_t, int16_t, &ConvertKernels::sc8ToSC16>, nullptr, false}},
+    {false, CONVERT_WIRE_SC8, SOAPY_SDR_CS8, 1, {&copyToHost<2>, nullptr, true}},
+    {false, CONVERT_WIRE_SC8, SOAPY_SDR_CF32, 1, {&toHostScaled1<int8_t, &ConvertKernels::sc8ToCF32, 128>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CS16, 1, {&toHost1<uint8_t, int16_t, &ConvertKernels::sc12ToSC16>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CS8, 1, {&toHost1<uint8_t, int8_t, &ConvertKernels::sc12ToSC8>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CF32, 1, {&toHostScaled1<uint8_t, &ConvertKernels::sc12ToCF32, 2048>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CS12, 1, {&copyToHost<3>, nullptr, true}},
+
+    //receive, two channels
+    {false, CONVERT_WIRE_SC16, SOAPY_SDR_CS16, 2, {&toHost2<int16_t, int16_t, &ConvertKernels::deinterleaveSC16>, nullptr, false}},
+    {false, CONVERT_WIRE_SC16, SOAPY_SDR_CS8, 2, {&toHost2<int16_t, int8_t, &ConvertKernels::deinterleaveSC16ToSC8>, nullptr, false}},
+    {false, CONVERT_WIRE_SC16, SOAPY_SDR_CF32, 2, {&toHostScaled2<int16_t, &ConvertKernels::deinterleaveSC16ToCF32, 2048>, nullptr, false}},
+    {false, CONVERT_WIRE_SC8, SOAPY_SDR_CS16, 2, {&toHost2<int8_t, int16_t, &ConvertKernels::deinterleaveSC8ToSC16>, nullptr, false}},
+    {false, CONVERT_WIRE_SC8, SOAPY_SDR_CS8, 2, {&toHost2<int8_t, int8_t, &ConvertKernels::deinterleaveSC8>, nullptr, false}},
+    {false, CONVERT_WIRE_SC8, SOAPY_SDR_CF32, 2, {&toHostScaled2<int8_t, &ConvertKernels::deinterleaveSC8ToCF32, 128>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CS16, 2, {&toHost2<uint8_t, int16_t, &ConvertKernels::deinterleaveSC12ToSC16>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CS8, 2, {&toHost2<uint8_t, int8_t, &ConvertKernels::deinterleaveSC12ToSC8>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CF32, 2, {&toHostScaled2<uint8_t, &ConvertKernels::deinterleaveSC12ToCF32, 2048>, nullptr, false}},
+    {false, CONVERT_WIRE_SC12, SOAPY_SDR_CS12, 2, {&toHost2<uint8_t, uint8_t, &ConvertKernels::deinterleaveSC12>, nullptr, false}},
+
+    //transmit, one channel
+    {true, CONVERT_WIRE_SC16, SOAPY_SDR_CS16, 1, {nullptr, &copyToWire<4>, true}},
+    {true, CONVERT_WIRE_SC16, SOAPY_SDR_CS8, 1, {nullptr, &toWire1<int8_t, int16_t, &ConvertKernels::sc8ToSC16>, false}},
+    {true, CONVERT_WIRE_SC16, SOAPY_SDR_CF32, 1, {nullptr, &toWireScaled1<int16_t, &ConvertKernels::cf32ToSC16, 2048>, false}},
+    {true, CONVERT_WIRE_SC8, SOAPY_SDR_CS16, 1, {nullptr, &toWire1<int16_t, int8_t, &ConvertKernels::sc16ToSC8>, false}},
+    {true, CONVERT_WIRE_SC8, SOAPY_SDR_CS8, 1, {nullptr, &copyToWire<2>, true}},
+    {true, CONVERT_WIRE_SC8, SOAPY_SDR_CF32, 1, {nullptr, &toWireScaled1<int8_t, &ConvertKernels::cf32ToSC8, 128>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CS16, 1, {nullptr, &toWire1<int16_t, uint8_t, &ConvertKernels::sc16ToSC12>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CS8, 1, {nullptr, &toWire1<int8_t, uint8_t, &ConvertKernels::sc8ToSC12>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CF32, 1, {nullptr, &toWireScaled1<uint8_t, &ConvertKernels::cf32ToSC12, 2048>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CS12, 1, {nullptr, &copyToWire<3>, true}},
+
+    //transmit, two channels
+    {true, CONVERT_WIRE_SC16, SOAPY_SDR_CS16, 2, {nullptr, &toWire2<int16_t, int16_t, &ConvertKernels::interleaveSC16>, false}},
+    {true, CONVERT_WIRE_SC16, SOAPY_SDR_CS8, 2, {nullptr, &toWire2<int8_t, int16_t, &ConvertKernels::interleaveSC8ToSC16>, false}},
+    {true, CONVERT_WIRE_SC16, SOAPY_SDR_CF32, 2, {nullptr, &toWireScaled2<int16_t, &ConvertKernels::interleaveCF32ToSC16, 2048>, false}},
+    {true, CONVERT_WIRE_SC8, SOAPY_SDR_CS16, 2, {nullptr, &toWire2<int16_t, int8_t, &ConvertKernels::interleaveSC16ToSC8>, false}},
+    {true, CONVERT_WIRE_SC8, SOAPY_SDR_CS8, 2, {nullptr, &toWire2<int8_t, int8_t, &ConvertKernels::interleaveSC8>, false}},
+    {true, CONVERT_WIRE_SC8, SOAPY_SDR_CF32, 2, {nullptr, &toWireScaled2<int8_t, &ConvertKernels::interleaveCF32ToSC8, 128>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CS16, 2, {nullptr, &toWire2<int16_t, uint8_t, &ConvertKernels::interleaveSC16ToSC12>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CS8, 2, {nullptr, &toWire2<int8_t, uint8_t, &ConvertKernels::interleaveSC8ToSC12>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CF32, 2, {nullptr, &toWireScaled2<uint8_t, &ConvertKernels::interleaveCF32ToSC12, 2048>, false}},
+    {true, CONVERT_WIRE_SC12, SOAPY_SDR_CS12, 2, {nullptr, &toWire2<uint8_t, uint8_t, &ConvertKernels::interleaveSC12>, false}},
+};
+
+const StreamConverter *findStreamConverter(
+    const bool isTx,
+    const ConvertWireFormat wire,
+    const std::string &hostFormat,
+    const size_t numChans)
+{
+    for (const auto &entry : streamConverters)
+    {
+        if (entry.isTx != isTx or entry.wire != wire) continue;
+        if (hostFormat != entry.hostFormat or entry.numChans != numChans) continue;
+        return &entry.converter;
+    }
+    return nullptr;
+}
+
+void fillSamples(void *output, const void *sample, const size_t sampleSize, const size_t numElems)
+{
+    if (numElems == 0) return;
+    char *out = reinterpret_cast<char *>(output);
+    std::memcpy(out, sample, sampleSize);
+    size_t filled = 1;
+    while (filled < numElems)
+    {
+        const size_t n = std::min(filled, numElems - filled);
+        std::memcpy(out + filled*sampleSize, out, n*sampleSize);
+        filled += n;
+    }
+}
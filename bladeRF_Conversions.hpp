@@ -0,0 +1,160 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*!
+ * Sample conversion kernels used by the streaming implementation.
+ * Each entry points to the fastest implementation supported by the host CPU.
+ * Lengths are in scalars, which is twice the number of complex samples,
+ * except for the (de)interleave kernels which take the number of
+ * complex samples per channel. Conversions between the 16-bit and 8-bit
+ * integer formats shift between the Q11 and Q7 scaling and saturate.
+ * The 12-bit packed wire format stores each complex sample in 3 bytes,
+ * I in the low 12 bits and Q in the high 12 bits, little endian,
+ * with the same Q11 scaling as the 16-bit format.
+ */
+struct ConvertKernels
+{
+    //! name of the selected instruction set (generic, sse2, ssse3, avx2, avx512, neon)
+    const char *isa;
+
+    //! convert signed 16-bit wire samples to floats with the given scale factor
+    void (*sc16ToCF32)(const int16_t *in, float *out, const size_t len, const float scale);
+
+    //! convert signed 8-bit wire samples to floats with the given scale factor
+    void (*sc8ToCF32)(const int8_t *in, float *out, const size_t len, const float scale);
+
+    //! convert floats to signed 16-bit wire samples, saturating to the 12-bit range
+    void (*cf32ToSC16)(const float *in, int16_t *out, const size_t len, const float scale);
+
+    //! convert floats to signed 8-bit wire samples, saturating to the 8-bit range
+    void (*cf32ToSC8)(const float *in, int8_t *out, const size_t len, const float scale);
+
+    //! widen signed 8-bit samples to signed 16-bit samples
+    void (*sc8ToSC16)(const int8_t *in, int16_t *out, const size_t len);
+
+    //! narrow signed 16-bit samples to signed 8-bit samples
+    void (*sc16ToSC8)(const int16_t *in, int8_t *out, const size_t len);
+
+    //! unpack 12-bit packed wire samples to signed 16-bit samples
+    void (*sc12ToSC16)(const uint8_t *in, int16_t *out, const size_t len);
+
+    //! unpack 12-bit packed wire samples to floats with the given scale factor
+    void (*sc12ToCF32)(const uint8_t *in, float *out, const size_t len, const float scale);
+
+    //! unpack 12-bit packed wire samples to 8-bit samples
+    void (*sc12ToSC8)(const uint8_t *in, int8_t *out, const size_t len);
+
+    //! pack 8-bit samples into 12-bit wire samples
+    void (*sc8ToSC12)(const int8_t *in, uint8_t *out, const size_t len);
+
+    //! pack signed 16-bit samples into 12-bit wire samples, saturating to the 12-bit range
+    void (*sc16ToSC12)(const int16_t *in, uint8_t *out, const size_t len);
+
+    //! pack floats into 12-bit wire samples, saturating to the 12-bit range
+    void (*cf32ToSC12)(const float *in, uint8_t *out, const size_t len, const float scale);
+
+    //! split two channel wire samples into per-channel host buffers
+    void (*deinterleaveSC16)(const int16_t *in, int16_t *out0, int16_t *out1, const size_t numElems);
+    void (*deinterleaveSC8)(const int8_t *in, int8_t *out0, int8_t *out1, const size_t numElems);
+    void (*deinterleaveSC12)(const uint8_t *in, uint8_t *out0, uint8_t *out1, const size_t numElems);
+    void (*deinterleaveSC16ToCF32)(const int16_t *in, float *out0, float *out1, const size_t numElems, const float scale);
+    void (*deinterleaveSC8ToCF32)(const int8_t *in, float *out0, float *out1, const size_t numElems, const float scale);
+    void (*deinterleaveSC16ToSC8)(const int16_t *in, int8_t *out0, int8_t *out1, const size_t numElems);
+    void (*deinterleaveSC8ToSC16)(const int8_t *in, int16_t *out0, int16_t *out1, const size_t numElems);
+    void (*deinterleaveSC12ToSC16)(const uint8_t *in, int16_t *out0, int16_t *out1, const size_t numElems);
+    void (*deinterleaveSC12ToCF32)(const uint8_t *in, float *out0, float *out1, const size_t numElems, const float scale);
+    void (*deinterleaveSC12ToSC8)(const uint8_t *in, int8_t *out0, int8_t *out1, const size_t numElems);
+
+    //! merge per-channel host buffers into two channel wire samples
+    void (*interleaveSC16)(const int16_t *in0, const int16_t *in1, int16_t *out, const size_t numElems);
+    void (*interleaveSC8)(const int8_t *in0, const int8_t *in1, int8_t *out, const size_t numElems);
+    void (*interleaveSC12)(const uint8_t *in0, const uint8_t *in1, uint8_t *out, const size_t numElems);
+    void (*interleaveCF32ToSC16)(const float *in0, const float *in1, int16_t *out, const size_t numElems, const float scale);
+    void (*interleaveCF32ToSC8)(const float *in0, const float *in1, int8_t *out, const size_t numElems, const float scale);
+    void (*interleaveSC16ToSC8)(const int16_t *in0, const int16_t *in1, int8_t *out, const size_t numElems);
+    void (*interleaveSC8ToSC16)(const int8_t *in0, const int8_t *in1, int16_t *out, const size_t numElems);
+    void (*interleaveSC16ToSC12)(const int16_t *in0, const int16_t *in1, uint8_t *out, const size_t numElems);
+    void (*interleaveCF32ToSC12)(const float *in0, const float *in1, uint8_t *out, const size_t numElems, const float scale);
+    void (*interleaveSC8ToSC12)(const int8_t *in0, const int8_t *in1, uint8_t *out, const size_t numElems);
+};
+
+/*!
+ * Get the conversion kernels for this host.
+ * The CPU features are probed once on the first call.
+ */
+const ConvertKernels &getConvertKernels(void);
+
+//! sample layouts on the wire, independent of the metadata framing
+enum ConvertWireFormat
+{
+    CONVERT_WIRE_SC16, //!< 16-bit I/Q with Q11 scaling
+    CONVERT_WIRE_SC8, //!< 8-bit I/Q with Q7 scaling
+    CONVERT_WIRE_SC12, //!< 12-bit packed I/Q with Q11 scaling
+};
+
+/*!
+ * Moves samples between a wire buffer and the per-channel host buffers
+ * of a stream. numElems is the number of complex samples per channel.
+ * Only the function for the direction of the entry is set.
+ */
+struct StreamConverter
+{
+    //! wire samples into the host buffers (RX)
+    void (*toHost)(const void *input, void * const *buffs, const size_t numElems);
+
+    //! host buffers into wire samples (TX)
+    void (*toWire)(const void * const *buffs, void *output, const size_t numElems);
+
+    //! the host buffer has the wire layout and can be used in place
+    bool passthrough;
+};
+
+/*!
+ * Look up the converter for a stream configuration.
+ * The table is keyed by direction, wire format, host format and channel count,
+ * streams resolve their entry once at setup.
+ * \param isTx true for the transmit direction
+ * \param wire the sample layout on the wire
+ * \param hostFormat the SoapySDR stream format string
+ * \param numChans the number of channels in the stream
+ * \return the converter or nullptr when the combination is not supported
+ */
+const StreamConverter *findStreamConverter(
+    const bool isTx,
+    const ConvertWireFormat wire,
+    const std::string &hostFormat,
+    const size_t numChans);
+
+/*!
+ * Repeat one host sample numElems times, used to synthesize missing samples.
+ * The filled region doubles with each copy so the work is done by wide memcpy.
+ * \param output the buffer to fill with numElems samples
+ * \param sample the sample to repeat
+ * \param sampleSize the size of the sample in bytes
+ * \param numElems the number of samples to write
+ */
+void fillSamples(void *output, const void *sample, const size_t sampleSize, const size_t numElems);
@@ -0,0 +1,237 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "bladeRF_SoapySDR.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <algorithm> //min, max
+#include <stdexcept>
+#include <sstream>
+#include <set>
+#include <cmath>
+
+//quick tune profiles per direction, NUM_BBP_FASTLOCK_PROFILES in libbladeRF
+#define MAX_QUICK_TUNES 256
+
+//default lead time of the first hop, so the hop thread can queue it ahead
+#define HOP_START_LEAD_NS 10000000 //10 ms
+
+//bounds on how long the hop thread sleeps between filling the retune queue
+#define HOP_MIN_WAIT_US 100
+#define HOP_MAX_WAIT_US 10000
+
+/*******************************************************************
+ * Quick tunes
+ ******************************************************************/
+
+const bladerf_quick_tune &bladeRF_SoapySDR::calibrateQuickTune(const int direction, const size_t channel, const bladerf_frequency frequency)
+{
+    const auto key = std::make_tuple(direction, channel, frequency);
+    const auto it = _quickTunes.find(key);
+    if (it != _quickTunes.end()) return it->second;
+
+    if (_quickTuneProfiles[direction] >= MAX_QUICK_TUNES)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "No quick tune profile left for %llu Hz, load the FPGA to reset them", (unsigned long long)(frequency));
+        throw std::runtime_error("calibrateQuickTune() no quick tune profile left");
+    }
+
+    this->setRfFrequency(direction, channel, double(frequency));
+
+    bladerf_quick_tune quickTune;
+    if (not this->getQuickTune(direction, channel, quickTune))
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "Cannot get the quick tune for %llu Hz", (unsigned long long)(frequency));
+        throw std::runtime_error("calibrateQuickTune() cannot get the quick tune");
+    }
+    return _quickTunes[key] = quickTune;
+}
+
+void bladeRF_SoapySDR::clearQuickTunes(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_hopMutex);
+        _hopSchedules.clear();
+    }
+    _hopPlans.clear();
+    _quickTunes.clear();
+    _quickTuneProfiles.clear();
+}
+
+/*******************************************************************
+ * Hop plans
+ ******************************************************************/
+
+void bladeRF_SoapySDR::setHopPlan(const int direction, const size_t channel, const std::string &value)
+{
+    std::vector<bladerf_frequency> plan;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (item.find_first_not_of(" \t") == std::string::npos) continue;
+        plan.push_back(bladerf_frequency(std::round(std::stod(item))));
+    }
+
+    //fail before tuning when the new frequencies do not fit in the profiles left
+    std::set<bladerf_frequency> uncalibrated;
+    for (const auto freq : plan)
+    {
+        if (_quickTunes.count(std::make_tuple(direction, channel, freq)) == 0) uncalibrated.insert(freq);
+    }
+    if (_quickTuneProfiles[direction] + uncalibrated.size() > MAX_QUICK_TUNES)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "Hop plan needs %d new quick tune profiles, %d are left",
+            int(uncalibrated.size()), int(MAX_QUICK_TUNES - _quickTuneProfiles[direction]));
+        throw std::runtime_error("setHopPlan() not enough quick tune profiles");
+    }
+
+    //hopping would retune the channel while it is being calibrated
+    this->setHopSchedule(direction, channel, "");
+    _hopPlans.erase(std::make_pair(direction, channel));
+
+    for (const auto freq : uncalibrated) this->calibrateQuickTune(direction, channel, freq);
+    _hopPlans[std::make_pair(direction, channel)] = plan;
+
+    SoapySDR::logf(SOAPY_SDR_INFO, "setHopPlan(%s, %d) %d frequencies, %d quick tune profiles used",
+        direction==SOAPY_SDR_RX?"Rx":"Tx", int(channel), int(plan.size()), int(_quickTuneProfiles[direction]));
+}
+
+void bladeRF_SoapySDR::setHopSchedule(const int direction, const size_t channel, const std::string &value)
+{
+    const auto key = std::make_pair(direction, channel);
+    const SoapySDR::Kwargs args = SoapySDR::KwargsFromString(value);
+
+    //a queued frequency must not land between the hops
+    this->drainControl(direction, channel);
+
+    //stop feeding the current schedule, then drop the hops the fpga has queued
+    {
+        std::lock_guard<std::mutex> lock(_hopMutex);
+        _hopSchedules.erase(key);
+    }
+    const int ret = bladerf_cancel_scheduled_retunes(_dev, _toch(direction, channel));
+    if (ret != 0) SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_cancel_scheduled_retunes() returned %s", _err2str(ret).c_str());
+    _shadow.invalidate(bladeRF_ShadowCache::FREQUENCY, direction);
+    _shadow.invalidate(bladeRF_ShadowCache::GAIN, direction);
+    if (args.empty()) return;
+
+    const auto planIt = _hopPlans.find(key);
+    if (planIt == _hopPlans.end() or planIt->second.empty())
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "No hop plan for %s channel %d", direction==SOAPY_SDR_RX?"Rx":"Tx", int(channel));
+        throw std::runtime_error("setHopSchedule() no hop plan");
+    }
+
+    HopSchedule schedule;
+    for (const auto freq : planIt->second) schedule.hops.push_back(_quickTunes.at(std::make_tuple(direction, channel, freq)));
+    schedule.startNs = (args.count("start") != 0)? std::stoll(args.at("start")) : this->getHardwareTime("estimate") + HOP_START_LEAD_NS;
+    schedule.dwellNs = (args.count("dwell") != 0)? std::stoll(args.at("dwell")) : 0;
+    schedule.count = (args.count("count") != 0)? size_t(std::stoull(args.at("count"))) : schedule.hops.size();
+    schedule.next = 0;
+    schedule.missed = 0;
+    schedule.errors = 0;
+    if (schedule.dwellNs <= 0) throw std::runtime_error("setHopSchedule() dwell must be a positive time in ns");
+
+    std::lock_guard<std::mutex> lock(_hopMutex);
+    _hopSchedules[key] = schedule;
+    if (not _hopRunning)
+    {
+        _hopRunning = true;
+        _hopThread = std::thread(&bladeRF_SoapySDR::hopThreadLoop, this);
+    }
+    _hopCond.notify_all();
+}
+
+std::string bladeRF_SoapySDR::getHopSchedule(const int direction, const size_t channel) const
+{
+    std::lock_guard<std::mutex> lock(_hopMutex);
+    const auto it = _hopSchedules.find(std::make_pair(direction, channel));
+    if (it == _hopSchedules.end()) return "";
+
+    const HopSchedule &schedule = it->second;
+    SoapySDR::Kwargs status;
+    status["start"] = std::to_string(schedule.startNs);
+    status["dwell"] = std::to_string(schedule.dwellNs);
+    status["count"] = std::to_string(schedule.count);
+    status["scheduled"] = std::to_string(schedule.next);
+    status["missed"] = std::to_string(schedule.missed);
+    status["errors"] = std::to_string(schedule.errors);
+    status["active"] = (schedule.count == 0 or schedule.next < schedule.count)? "true" : "false";
+    return SoapySDR::KwargsToString(status);
+}
+
+/*******************************************************************
+ * Hop thread
+ ******************************************************************/
+
+void bladeRF_SoapySDR::hopThreadLoop(void)
+{
+    std::unique_lock<std::mutex> lock(_hopMutex);
+    while (_hopRunning)
+    {
+        bool active = false;
+        long long waitUs = HOP_MAX_WAIT_US;
+        for (auto &entry : _hopSchedules)
+        {
+            const int direction = entry.first.first;
+            const size_t channel = entry.first.second;
+            HopSchedule &schedule = entry.second;
+
+            //queue hops until the fpga retune queue is full
+            while (schedule.count == 0 or schedule.next < schedule.count)
+            {
+                const long long timeNs = schedule.startNs + (long long)(schedule.next)*schedule.dwellNs;
+                const long long ticks = (direction == SOAPY_SDR_RX)?_timeNsToRxTicks(timeNs):_timeNsToTxTicks(timeNs);
+                bladerf_quick_tune &hop = schedule.hops[schedule.next % schedule.hops.size()];
+                const int ret = bladerf_schedule_retune(_dev, _toch(direction, channel), bladerf_timestamp(ticks), 0, &hop);
+                if (ret == BLADERF_ERR_QUEUE_FULL) break;
+                schedule.next++;
+                if (ret == 0) this->holdRetune(direction, timeNs);
+                else if (ret == BLADERF_ERR_TIME_PAST) schedule.missed++;
+                else
+                {
+                    //skip the hop and try the next one on the next pass
+                    SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_schedule_retune() returned %s", _err2str(ret).c_str());
+                    schedule.errors++;
+                    break;
+                }
+            }
+            if (schedule.count != 0 and schedule.next >= schedule.count) continue;
+
+            //wake up while a few hops are still queued
+            active = true;
+            waitUs = std::min(waitUs, std::max<long long>(HOP_MIN_WAIT_US, (4*schedule.dwellNs)/1000));
+        }
+
+        if (active) _hopCond.wait_for(lock, std::chrono::microseconds(waitUs));
+        else _hopCond.wait(lock);
+    }
+}
+
+void bladeRF_SoapySDR::stopHopThread(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_hopMutex);
+        _hopRunning = false;
+        _hopCond.notify_all();
+    }
+    if (_hopThread.joinable()) _hopThread.join();
+}
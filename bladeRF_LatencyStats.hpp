@@ -0,0 +1,128 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <limits>
+
+/*!
+ * Running statistics of a latency in nanoseconds.
+ * Samples go into a log-linear histogram with 8 bins per octave, so the
+ * percentiles are within 1/8 of an octave, and recording is a handful of
+ * relaxed atomic operations that never block the streaming path.
+ * A single writer records while any thread reads the statistics.
+ */
+class bladeRF_LatencyStats
+{
+public:
+    bladeRF_LatencyStats(void)
+    {
+        this->reset();
+    }
+
+    //! clear the statistics, only while the writer is idle
+    void reset(void)
+    {
+        for (auto &bin : _bins) bin.store(0, std::memory_order_relaxed);
+        _count.store(0);
+        _last.store(0);
+        _min.store(std::numeric_limits<long long>::max());
+        _max.store(0);
+    }
+
+    void record(long long ns)
+    {
+        if (ns < 0) ns = 0;
+        _bins[binIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        _last.store(ns, std::memory_order_relaxed);
+        if (ns < _min.load(std::memory_order_relaxed)) _min.store(ns, std::memory_order_relaxed);
+        if (ns > _max.load(std::memory_order_relaxed)) _max.store(ns, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_release);
+    }
+
+    unsigned long long count(void) const
+    {
+        return _count.load(std::memory_order_acquire);
+    }
+
+    long long last(void) const
+    {
+        return _last.load(std::memory_order_relaxed);
+    }
+
+    long long min(void) const
+    {
+        return (this->count() == 0)? 0 : _min.load(std::memory_order_relaxed);
+    }
+
+    long long max(void) const
+    {
+        return _max.load(std::memory_order_relaxed);
+    }
+
+    //! the latency below which the fraction p of the samples fall, 0 without samples
+    long long percentile(const double p) const
+    {
+        unsigned long long total = 0;
+        for (const auto &bin : _bins) total += bin.load(std::memory_order_relaxed);
+        if (total == 0) return 0;
+
+        const unsigned long long rank = std::max<unsigned long long>(1, (unsigned long long)(p * double(total) + 0.5));
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < NUM_BINS; i++)
+        {
+            seen += _bins[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(binCenter(i), this->max());
+        }
+        return this->max();
+    }
+
+private:
+    static const size_t SUB_BITS = 3;
+    static const size_t NUM_BINS = 64 << SUB_BITS;
+
+    //! the octave of the value selects the bin group, the bits below its msb the bin
+    static size_t binIndex(const long long ns)
+    {
+        const unsigned long long v = (unsigned long long)(ns);
+        if (v < (1ull << SUB_BITS)) return size_t(v);
+        const size_t octave = 63 - __builtin_clzll(v);
+        const size_t sub = size_t(v >> (octave - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+        return ((octave - SUB_BITS + 1) << SUB_BITS) + sub;
+    }
+
+    static long long binCenter(const size_t index)
+    {
+        if (index < (1 << SUB_BITS)) return (long long)(index);
+        const size_t octave = (index >> SUB_BITS) + SUB_BITS - 1;
+        const size_t sub = index & ((1 << SUB_BITS) - 1);
+        const unsigned long long low = (1ull << octave) + ((unsigned long long)(sub) << (octave - SUB_BITS));
+        return (long long)(low + (1ull << (octave - SUB_BITS)) / 2);
+    }
+
+    std::atomic<unsigned long long> _bins[NUM_BINS];
+    std::atomic<unsigned long long> _count;
+    std::atomic<long long> _last;
+    std::atomic<long long> _min;
+    std::atomic<long long> _max;
+};
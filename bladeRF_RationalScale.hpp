@@ -0,0 +1,174 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/*!
+ * Exact scaling of a 64-bit count by a rational num/den, rounded to nearest.
+ * The quotient is estimated with a precomputed 64.64 fixed-point multiplier
+ * and corrected from the exact 128-bit remainder, so conversions are exact
+ * for any count without a division or a branch on the streaming path.
+ * Targets without __int128 build the 128-bit arithmetic from 64-bit halves.
+ */
+class bladeRF_RationalScale
+{
+public:
+    bladeRF_RationalScale(void)
+    {
+        this->set(1, 1);
+    }
+
+    //! set the ratio, terms larger than 63 bits after reduction lose precision
+    void set(uint64_t num, uint64_t den)
+    {
+        const uint64_t g = gcd(num, den);
+        num /= g;
+        den /= g;
+        while (num >= (1ull << 63) or den >= (1ull << 63))
+        {
+            num >>= 1;
+            den >>= 1;
+        }
+        if (den == 0) den = 1;
+        _num = num;
+        _den = den;
+        _half = den / 2;
+        _mult = div(num, _half, den);
+    }
+
+    long long operator()(const long long x) const
+    {
+        //work on the magnitude and restore the sign, so rounding is symmetric
+        const uint64_t neg = uint64_t(x >> 63);
+        const uint64_t ux = (uint64_t(x) ^ neg) - neg;
+
+        //the multiplier is within 2^-65 of num/den, so over 63 bits the estimate
+        //is within 1/4 of the exact quotient, and at most one below the rounded result
+        const u128 lo = mul(ux, low64(_mult));
+        const u128 hi = mul(ux, high64(_mult));
+        u128 q = add(hi, make(0, high64(lo)));
+        const u128 rem = sub(add(mul(ux, _num), make(0, _half)), mulLow(q, _den));
+        if (geq(rem, make(0, _den))) q = add(q, make(0, 1));
+
+        return (long long)((low64(q) ^ neg) - neg);
+    }
+
+    //! greatest common divisor, 1 when both are zero so it can always divide
+    static uint64_t gcd(uint64_t a, uint64_t b)
+    {
+        while (b != 0)
+        {
+            const uint64_t t = a % b;
+            a = b;
+            b = t;
+        }
+        return (a == 0)? 1 : a;
+    }
+
+private:
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 u128;
+
+    static u128 make(const uint64_t hi, const uint64_t lo) {return ((u128)(hi) << 64) | lo;}
+    static uint64_t high64(const u128 a) {return uint64_t(a >> 64);}
+    static uint64_t low64(const u128 a) {return uint64_t(a);}
+    static u128 mul(const uint64_t a, const uint64_t b) {return (u128)(a) * b;}
+    static u128 mulLow(const u128 a, const uint64_t b) {return a * b;}
+    static u128 add(const u128 a, const u128 b) {return a + b;}
+    static u128 sub(const u128 a, const u128 b) {return a - b;}
+    static bool geq(const u128 a, const u128 b) {return a >= b;}
+
+    //! ((hi << 64) + lo) / den
+    static u128 div(const uint64_t hi, const uint64_t lo, const uint64_t den) {return make(hi, lo) / den;}
+#else
+    //portable 128-bit arithmetic for targets without __int128, such as 32-bit builds
+    struct u128
+    {
+        uint64_t hi;
+        uint64_t lo;
+    };
+
+    static u128 make(const uint64_t hi, const uint64_t lo) {u128 r; r.hi = hi; r.lo = lo; return r;}
+    static uint64_t high64(const u128 a) {return a.hi;}
+    static uint64_t low64(const u128 a) {return a.lo;}
+
+    //! 64x64 -> 128 multiply from 32-bit halves
+    static u128 mul(const uint64_t a, const uint64_t b)
+    {
+        const uint64_t aLo = a & 0xffffffffull, aHi = a >> 32;
+        const uint64_t bLo = b & 0xffffffffull, bHi = b >> 32;
+        const uint64_t ll = aLo * bLo;
+        const uint64_t lh = aLo * bHi;
+        const uint64_t hl = aHi * bLo;
+        const uint64_t hh = aHi * bHi;
+        const uint64_t mid = (ll >> 32) + (lh & 0xffffffffull) + (hl & 0xffffffffull);
+        return make(hh + (lh >> 32) + (hl >> 32) + (mid >> 32), (mid << 32) | (ll & 0xffffffffull));
+    }
+
+    //! the low 128 bits of a 128x64 multiply
+    static u128 mulLow(const u128 a, const uint64_t b)
+    {
+        const u128 p = mul(a.lo, b);
+        return make(p.hi + a.hi * b, p.lo);
+    }
+
+    static u128 add(const u128 a, const u128 b)
+    {
+        const uint64_t lo = a.lo + b.lo;
+        return make(a.hi + b.hi + (lo < a.lo), lo);
+    }
+
+    static u128 sub(const u128 a, const u128 b)
+    {
+        return make(a.hi - b.hi - (a.lo < b.lo), a.lo - b.lo);
+    }
+
+    static bool geq(const u128 a, const u128 b)
+    {
+        return (a.hi != b.hi)? (a.hi > b.hi) : (a.lo >= b.lo);
+    }
+
+    //! ((hi << 64) + lo) / den by long division, den is below 2^63
+    static u128 div(const uint64_t hi, const uint64_t lo, const uint64_t den)
+    {
+        uint64_t rem = hi % den;
+        uint64_t q = 0;
+        for (int bit = 63; bit >= 0; bit--)
+        {
+            rem = (rem << 1) | ((lo >> bit) & 1);
+            q <<= 1;
+            if (rem >= den)
+            {
+                rem -= den;
+                q |= 1;
+            }
+        }
+        return make(hi / den, q);
+    }
+#endif
+
+    uint64_t _num;
+    uint64_t _den;
+    uint64_t _half;
+    u128 _mult;
+};
@@ -0,0 +1,147 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+/*!
+ * Single producer, single consumer ring of preallocated slots.
+ * The producer fills back() and calls push(), the consumer reads front()
+ * and calls pop(). Neither side takes a lock unless it has to wait:
+ * waitFront() and waitBack() sleep on a condition variable and the
+ * opposite side only signals it when someone is waiting.
+ */
+template <typename T>
+class bladeRF_RingBuffer
+{
+public:
+
+    //! create a ring with capacity slots initialized from a prototype
+    bladeRF_RingBuffer(const size_t capacity, const T &init = T()):
+        _slots(capacity, init),
+        _readIndex(0),
+        _writeIndex(0),
+        _waiters(0)
+    {
+        return;
+    }
+
+    size_t capacity(void) const
+    {
+        return _slots.size();
+    }
+
+    //! the number of slots that are ready for the consumer
+    size_t size(void) const
+    {
+        return _writeIndex.load() - _readIndex.load();
+    }
+
+    //! the next slot to fill, or nullptr when full (producer)
+    T *back(void)
+    {
+        const size_t w = _writeIndex.load(std::memory_order_relaxed);
+        if (w - _readIndex.load(std::memory_order_acquire) >= _slots.size()) return nullptr;
+        return &_slots[w % _slots.size()];
+    }
+
+    //! hand the slot from back() to the consumer (producer)
+    void push(void)
+    {
+        _writeIndex.fetch_add(1);
+        this->notify();
+    }
+
+    //! the oldest filled slot, or nullptr when empty (consumer)
+    T *front(void)
+    {
+        const size_t r = _readIndex.load(std::memory_order_relaxed);
+        if (r == _writeIndex.load(std::memory_order_acquire)) return nullptr;
+        return &_slots[r % _slots.size()];
+    }
+
+    //! give the slot from front() back to the producer (consumer)
+    void pop(void)
+    {
+        _readIndex.fetch_add(1);
+        this->notify();
+    }
+
+    //! wait for a filled slot, true when front() is available
+    bool waitFront(const long timeoutUs)
+    {
+        return this->wait(timeoutUs, [this](void){return this->front() != nullptr;});
+    }
+
+    //! wait for an empty slot, true when back() is available
+    bool waitBack(const long timeoutUs)
+    {
+        return this->wait(timeoutUs, [this](void){return this->back() != nullptr;});
+    }
+
+    //! wait for the consumer to take every filled slot, true when empty (producer)
+    bool waitEmpty(const long timeoutUs)
+    {
+        return this->wait(timeoutUs, [this](void){return this->size() == 0;});
+    }
+
+    //! discard all filled slots, only while the producer is idle
+    void clear(void)
+    {
+        _readIndex.store(_writeIndex.load());
+        this->notify();
+    }
+
+private:
+    template <typename Pred>
+    bool wait(const long timeoutUs, Pred pred)
+    {
+        if (pred()) return true;
+        if (timeoutUs <= 0) return false;
+
+        //the waiter count is raised before the predicate is checked under the lock,
+        //so the other side either sees the waiter or the waiter sees the new index
+        _waiters.fetch_add(1);
+        std::unique_lock<std::mutex> lock(_mutex);
+        const bool ready = _cond.wait_for(lock, std::chrono::microseconds(timeoutUs), pred);
+        _waiters.fetch_sub(1);
+        return ready;
+    }
+
+    void notify(void)
+    {
+        if (_waiters.load() == 0) return;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cond.notify_all();
+    }
+
+    std::vector<T> _slots;
+    std::atomic<size_t> _readIndex;
+    std::atomic<size_t> _writeIndex;
+    std::atomic<int> _waiters;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+};
@@ -20,11 +20,14 @@
  */
 
 #include "bladeRF_SoapySDR.hpp"
+#include "bladeRF_AsyncStream.hpp"
+#include "bladeRF_RingBuffer.hpp"
 #include <SoapySDR/Logger.hpp>
-#include <algorithm> //find
+#include <algorithm> //find, max, sort
 #include <stdexcept>
 #include <cstdio>
 #include <cmath>
+#include <climits>
 
 //! convert bladerf range to a soapysdr range
 static SoapySDR::Range toRange(const bladerf_range* range)
@@ -32,6 +35,24 @@ static SoapySDR::Range toRange(const bladerf_range* range)
     return SoapySDR::Range(range->min*range->scale, range->max*range->scale, range->step*range->scale);
 }
 
+//! the most gain stages listed for a channel
+#define MAX_STAGES 8
+
+//! no scheduled retune is waiting to land
+#define NO_RETUNE_NS LLONG_MIN
+
+//! time for a scheduled retune to complete after its timestamp
+#define RETUNE_SETTLE_NS 1000000 //1 ms
+
+//! find a range in the capability snapshot
+static bool findRange(const std::map<std::string, SoapySDR::Range> &ranges, const std::string &name, SoapySDR::Range &range)
+{
+    const auto it = ranges.find(name);
+    if (it == ranges.end()) return false;
+    range = it->second;
+    return true;
+}
+
 /*******************************************************************
  * Device init/shutdown
  ******************************************************************/
@@ -40,20 +61,19 @@ bladeRF_SoapySDR::bladeRF_SoapySDR(const bladerf_devinfo &devinfo):
     _isBladeRF1(false),
     _rxSampRate(1.0),
     _txSampRate(1.0),
-    _inTxBurst(false),
-    _rxFloats(false),
-    _txFloats(false),
-    _rxOverflow(false),
-    _rxNextTicks(0),
-    _txNextTicks(0),
+    _keepTimeline(false),
     _timeNsOffset(0),
-    _rxBuffSize(0),
-    _txBuffSize(0),
-    _rxMinTimeoutMs(0),
     _xb200Mode("disabled"),
     _samplingMode("internal"),
     _loopbackMode("disabled"),
-    _dev(NULL)
+    _dev(NULL),
+    _rxRetuneUntilNs(NO_RETUNE_NS),
+    _txRetuneUntilNs(NO_RETUNE_NS),
+    _hopRunning(false),
+    _asyncControl(false),
+    _controlQueued(0),
+    _controlApplied(0),
+    _controlErrors(0)
 
 {
     bladerf_devinfo info = devinfo;
@@ -69,9 +89,9 @@ bladeRF_SoapySDR::bladeRF_SoapySDR(const bladerf_devinfo &devinfo):
     _isBladeRF1 = std::string(bladerf_get_board_name(_dev)) == "bladerf1";
     _isBladeRF2 = std::string(bladerf_get_board_name(_dev)) == "bladerf2";
 
-    bladerf_serial serial;
-    ret = bladerf_get_serial_struct(_dev, &serial);
-    if (ret == 0) SoapySDR::logf(SOAPY_SDR_INFO, "bladerf_get_serial() = %s", serial.serial);
+    this->snapshotCapabilities();
+    const auto &hwInfo = this->capabilities()->hardwareInfo;
+    if (hwInfo.count("serial") != 0) SoapySDR::logf(SOAPY_SDR_INFO, "bladerf_get_serial() = %s", hwInfo.at("serial").c_str());
 
     //initialize the sample rates to something
     this->setSampleRate(SOAPY_SDR_RX, 0, 4e6);
@@ -80,26 +100,30 @@ bladeRF_SoapySDR::bladeRF_SoapySDR(const bladerf_devinfo &devinfo):
 
 bladeRF_SoapySDR::~bladeRF_SoapySDR(void)
 {
+    //queued settings are applied before the device is closed
+    this->stopControlThread();
+    this->stopHopThread();
+
+    //streaming threads must stop before the device is closed
+    delete _rx.async;
+    delete _tx.async;
+    this->stopRxThread();
+    this->stopTxThread();
+    delete _rx.ring;
+    delete _tx.ring;
+
     SoapySDR::logf(SOAPY_SDR_INFO, "bladerf_close()");
     if (_dev != NULL) bladerf_close(_dev);
 }
 
-/*******************************************************************
- * Identification API
- ******************************************************************/
-std::string bladeRF_SoapySDR::getHardwareKey(void) const
-{
-    return bladerf_get_board_name(_dev);
-}
-
-SoapySDR::Kwargs bladeRF_SoapySDR::getHardwareInfo(void) const
+void bladeRF_SoapySDR::snapshotCapabilities(void)
 {
-    SoapySDR::Kwargs info;
+    std::shared_ptr<DeviceCapabilities> caps(new DeviceCapabilities());
 
     {
         bladerf_serial serial;
         int ret = bladerf_get_serial_struct(_dev, &serial);
-        if (ret == 0) info["serial"] = serial.serial;
+        if (ret == 0) caps->hardwareInfo["serial"] = serial.serial;
     }
 
     {
@@ -107,22 +131,65 @@ SoapySDR::Kwargs bladeRF_SoapySDR::getHardwareInfo(void) const
         int ret = bladerf_get_fpga_size(_dev, &fpgaSize);
         char fpgaStr[100];
         sprintf(fpgaStr, "%u", int(fpgaSize));
-        if (ret == 0) info["fpga_size"] = fpgaStr;
+        if (ret == 0) caps->hardwareInfo["fpga_size"] = fpgaStr;
     }
 
     {
         struct bladerf_version verInfo;
         int ret = bladerf_fw_version(_dev, &verInfo);
-        if (ret == 0) info["fw_version"] = verInfo.describe;
+        if (ret == 0) caps->hardwareInfo["fw_version"] = verInfo.describe;
     }
 
     {
         struct bladerf_version verInfo;
         int ret = bladerf_fpga_version(_dev, &verInfo);
-        if (ret == 0) info["fpga_version"] = verInfo.describe;
+        if (ret == 0) caps->hardwareInfo["fpga_version"] = verInfo.describe;
     }
 
-    return info;
+    const bladerf_loopback_modes *modes(nullptr);
+    const int numModes = bladerf_get_loopback_modes(_dev, &modes);
+    if (modes and numModes > 0) for (int i = 0; i < numModes; i++)
+    {
+        caps->loopbackModes.emplace_back(modes[i].name, modes[i].mode);
+    }
+
+    for (const int direction : {SOAPY_SDR_RX, SOAPY_SDR_TX})
+    {
+        auto &chans = (direction == SOAPY_SDR_RX)?caps->rx:caps->tx;
+        chans.resize(this->getNumChannels(direction));
+        for (size_t channel = 0; channel < chans.size(); channel++)
+        {
+            auto &chan = chans[channel];
+            const bladerf_channel ch = _toch(direction, channel);
+            const bladerf_range* range(nullptr);
+
+            chan.gainMode = this->probeGainMode(direction, channel);
+
+            const char *stages[MAX_STAGES];
+            const int numStages = bladerf_get_gain_stages(_dev, ch, (const char **)&stages, MAX_STAGES);
+            chan.gainsListed = numStages >= 0;
+            for (int i = 0; i < numStages; i++) chan.gains.push_back(stages[i]);
+
+            if (bladerf_get_frequency_range(_dev, ch, &range) == 0) chan.ranges["frequency"] = toRange(range);
+            if (bladerf_get_sample_rate_range(_dev, ch, &range) == 0) chan.ranges["sample_rate"] = toRange(range);
+            if (bladerf_get_bandwidth_range(_dev, ch, &range) == 0) chan.ranges["bandwidth"] = toRange(range);
+        }
+    }
+
+    std::atomic_store(&_caps, std::shared_ptr<const DeviceCapabilities>(caps));
+}
+
+/*******************************************************************
+ * Identification API
+ ******************************************************************/
+std::string bladeRF_SoapySDR::getHardwareKey(void) const
+{
+    return bladerf_get_board_name(_dev);
+}
+
+SoapySDR::Kwargs bladeRF_SoapySDR::getHardwareInfo(void) const
+{
+    return this->capabilities()->hardwareInfo;
 }
 
 /*******************************************************************
@@ -287,6 +354,14 @@ std::complex<double> bladeRF_SoapySDR::getIQBalance(const int direction, const s
  ******************************************************************/
 
 bool bladeRF_SoapySDR::hasGainMode(const int direction, const size_t channel) const
+{
+    const auto caps = this->capabilities();
+    const auto chan = this->channelCapabilities(caps, direction, channel);
+    if (chan != nullptr) return chan->gainMode;
+    return this->probeGainMode(direction, channel);
+}
+
+bool bladeRF_SoapySDR::probeGainMode(const int direction, const size_t channel) const
 {
     if (_toch(direction, channel) != BLADERF_CHANNEL_RX(channel)) {
         return false;
@@ -320,6 +395,10 @@ bool bladeRF_SoapySDR::hasGainMode(const int direction, const size_t channel) co
 void bladeRF_SoapySDR::setGainMode(const int direction, const size_t channel, const bool automatic)
 {
     if (direction == SOAPY_SDR_TX) return; //not supported on tx
+
+    //a queued gain must not land after the mode change
+    this->drainControl(direction, channel);
+    if (_shadow.unchanged(bladeRF_ShadowCache::GAIN_MODE, direction, channel, "", automatic)) return;
     bladerf_gain_mode gain_mode = automatic ? BLADERF_GAIN_AUTOMATIC : BLADERF_GAIN_MANUAL;
     const int ret = bladerf_set_gain_mode(_dev, _toch(direction, channel), gain_mode);
     if (ret != 0 and automatic) //only throw when mode is automatic, manual is default even when call bombs
@@ -327,6 +406,12 @@ void bladeRF_SoapySDR::setGainMode(const int direction, const size_t channel, co
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_gain_mode(%s) returned %s", automatic?"automatic":"manual", _err2str(ret).c_str());
         throw std::runtime_error("setGainMode() " + _err2str(ret));
     }
+
+    //the gains are under agc control or were left there by it
+    _shadow.invalidate(bladeRF_ShadowCache::GAIN, direction);
+    if (ret == 0) _shadow.set(bladeRF_ShadowCache::GAIN_MODE, direction, channel, "", automatic);
+    else _shadow.invalidate(bladeRF_ShadowCache::GAIN_MODE, direction);
+
     bladerf_gain_mode return_mode;
     bladerf_get_gain_mode(_dev, _toch(direction, channel), &return_mode);
     std::string gain_mode_string;
@@ -351,6 +436,10 @@ void bladeRF_SoapySDR::setGainMode(const int direction, const size_t channel, co
 bool bladeRF_SoapySDR::getGainMode(const int direction, const size_t channel) const
 {
     if (direction == SOAPY_SDR_TX) return false; //not supported on tx
+    double cached(0);
+    if (_shadow.get(bladeRF_ShadowCache::GAIN_MODE, direction, channel, "", cached)) return cached != 0;
+
+    const unsigned long long epoch = _shadow.epoch();
     bladerf_gain_mode gain_mode;
     int ret = bladerf_get_gain_mode(_dev, _toch(direction, channel), &gain_mode);
     if (ret != 0)
@@ -358,12 +447,17 @@ bool bladeRF_SoapySDR::getGainMode(const int direction, const size_t channel) co
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_gain_mode() returned %s", _err2str(ret).c_str());
         throw std::runtime_error("getGainMode() " + _err2str(ret));
     }
-    return gain_mode == BLADERF_GAIN_AUTOMATIC;
+    const bool automatic = gain_mode == BLADERF_GAIN_AUTOMATIC;
+    _shadow.put(bladeRF_ShadowCache::GAIN_MODE, direction, channel, "", automatic, epoch);
+    return automatic;
 }
 
 std::vector<std::string> bladeRF_SoapySDR::listGains(const int direction, const size_t channel) const
 {
-    #define MAX_STAGES 8
+    const auto caps = this->capabilities();
+    const auto chan = this->channelCapabilities(caps, direction, channel);
+    if (chan != nullptr and chan->gainsListed) return chan->gains;
+
     const char *stages[MAX_STAGES];
     int ret = bladerf_get_gain_stages(_dev, _toch(direction, channel), (const char **)&stages, MAX_STAGES);
     if (ret < 0)
@@ -379,26 +473,53 @@ std::vector<std::string> bladeRF_SoapySDR::listGains(const int direction, const
 
 void bladeRF_SoapySDR::setGain(const int direction, const size_t channel, const double value)
 {
-    const int ret = bladerf_set_gain(_dev, _toch(direction, channel), bladerf_gain(std::round(value)));
-    if (ret != 0)
-    {
-        SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_gain(%f) returned %s", value, _err2str(ret).c_str());
-        throw std::runtime_error("setGain() " + _err2str(ret));
-    }
+    if (this->queueControl(CONTROL_GAIN, direction, channel, "", value)) return;
+    this->setRfGain(direction, channel, "", value);
 }
 
 void bladeRF_SoapySDR::setGain(const int direction, const size_t channel, const std::string &name, const double value)
 {
+    if (this->queueControl(CONTROL_GAIN, direction, channel, name, value)) return;
+    this->setRfGain(direction, channel, name, value);
+}
+
+void bladeRF_SoapySDR::setRfGain(const int direction, const size_t channel, const std::string &name, const double value)
+{
+    //a pending retune moves the gains with the frequency, so the same value is set again
+    if (not this->retunePending(direction) and _shadow.unchanged(bladeRF_ShadowCache::GAIN, direction, channel, name, value)) return;
+
+    //the overall gain and the stages change each other, a failed set leaves them unknown
+    _shadow.invalidate(bladeRF_ShadowCache::GAIN, direction);
+
+    if (name.empty())
+    {
+        const int ret = bladerf_set_gain(_dev, _toch(direction, channel), bladerf_gain(std::round(value)));
+        if (ret != 0)
+        {
+            SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_gain(%f) returned %s", value, _err2str(ret).c_str());
+            throw std::runtime_error("setGain() " + _err2str(ret));
+        }
+        _shadow.set(bladeRF_ShadowCache::GAIN, direction, channel, name, value);
+        return;
+    }
+
     int ret = bladerf_set_gain_stage(_dev, _toch(direction, channel), name.c_str(), bladerf_gain(std::round(value)));
     if (ret != 0)
     {
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_gain_stage(%s, %f) returned %s", name.c_str(), value, _err2str(ret).c_str());
         throw std::runtime_error("setGain("+name+") " + _err2str(ret));
     }
+    _shadow.set(bladeRF_ShadowCache::GAIN, direction, channel, name, value);
 }
 
 double bladeRF_SoapySDR::getGain(const int direction, const size_t channel) const
 {
+    //the agc changes the gain behind the cache, and so does a retune before it lands
+    const bool cacheable = not this->getGainMode(direction, channel) and not this->retunePending(direction);
+    double cached(0);
+    if (cacheable and _shadow.get(bladeRF_ShadowCache::GAIN, direction, channel, "", cached)) return cached;
+
+    const unsigned long long epoch = _shadow.epoch();
     bladerf_gain gain(0);
     const int ret = bladerf_get_gain(_dev, _toch(direction, channel), &gain);
     if (ret != 0)
@@ -406,11 +527,17 @@ double bladeRF_SoapySDR::getGain(const int direction, const size_t channel) cons
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_gain() returned %s", _err2str(ret).c_str());
         throw std::runtime_error("getGain() " + _err2str(ret));
     }
+    if (cacheable) _shadow.put(bladeRF_ShadowCache::GAIN, direction, channel, "", double(gain), epoch);
     return double(gain);
 }
 
 double bladeRF_SoapySDR::getGain(const int direction, const size_t channel, const std::string &name) const
 {
+    const bool cacheable = not this->getGainMode(direction, channel) and not this->retunePending(direction);
+    double cached(0);
+    if (cacheable and _shadow.get(bladeRF_ShadowCache::GAIN, direction, channel, name, cached)) return cached;
+
+    const unsigned long long epoch = _shadow.epoch();
     bladerf_gain gain(0);
     int ret = bladerf_get_gain_stage(_dev, _toch(direction, channel), name.c_str(), &gain);
     if (ret != 0)
@@ -418,6 +545,7 @@ double bladeRF_SoapySDR::getGain(const int direction, const size_t channel, cons
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_gain_stage(%s) returned %s", name.c_str(), _err2str(ret).c_str());
         throw std::runtime_error("getGain("+name+") " + _err2str(ret));
     }
+    if (cacheable) _shadow.put(bladeRF_ShadowCache::GAIN, direction, channel, name, double(gain), epoch);
     return double(gain);
 }
 
@@ -473,19 +601,18 @@ void bladeRF_SoapySDR::setFrequency(const int direction, const size_t channel, c
             throw std::runtime_error("saveQuickTune is only available for BladeRF2.");
         }
 
+        //the queued changes of the channel come first, they would move the tuning being saved
+        this->drainControl(direction, channel);
         setRfFrequency(direction, channel, frequency);
 
-        auto quickTune = getQuickTune(direction, channel);
-        if (quickTune == nullptr)
+        bladerf_quick_tune quickTune;
+        if (!getQuickTune(direction, channel, quickTune))
         {
             SoapySDR::logf(SOAPY_SDR_ERROR, "Cannot set frequency for retune.");
             throw std::runtime_error("Cannot set frequency for retune.");
         }
 
-        auto quickTuneIter = _quickTunesByDirChanAndFreq.find({ direction, channel, frequency });
-        if (quickTuneIter != _quickTunesByDirChanAndFreq.end()) delete quickTuneIter->second;
-
-        _quickTunesByDirChanAndFreq[{direction, channel, frequency}] = quickTune;
+        _quickTunes[std::make_tuple(direction, channel, bladerf_frequency(std::round(frequency)))] = quickTune;
         return;
     }
 
@@ -500,8 +627,8 @@ void bladeRF_SoapySDR::setFrequency(const int direction, const size_t channel, c
             throw std::runtime_error("reuseQuickTune is only available for BladeRF2.");
         }
 
-        auto quickTuneIter = _quickTunesByDirChanAndFreq.find({ direction, channel, frequency });
-        if (quickTuneIter == _quickTunesByDirChanAndFreq.end())
+        auto quickTuneIter = _quickTunes.find(std::make_tuple(direction, channel, bladerf_frequency(std::round(frequency))));
+        if (quickTuneIter == _quickTunes.end())
         {
             SoapySDR::logf(SOAPY_SDR_ERROR, "Unkown quick tune for frequency %f and channel %d", frequency, channel);
             throw std::runtime_error("Unkown quick tune");
@@ -510,22 +637,32 @@ void bladeRF_SoapySDR::setFrequency(const int direction, const size_t channel, c
         auto value = args.find("timestamp");
         long long timestamp = value == args.end() ? 0 : std::stoll(value->second);
 
+        //a queued frequency must not land after the retune
+        this->drainControl(direction, channel);
         retune(direction, channel, timestamp, quickTuneIter->second);
         return;
     }
 
-    //Else, we simply set the RF frequency.
+    //Else, we simply set the RF frequency, or leave it to the control thread in async control mode.
+    if (this->queueControl(CONTROL_FREQUENCY, direction, channel, "", frequency)) return;
     setRfFrequency(direction, channel, frequency);
 }
 
 void bladeRF_SoapySDR::setRfFrequency(const int direction, const size_t channel, const double frequency)
 {
+    //a pending retune will move the frequency, so the same value is set again
+    if (not this->retunePending(direction) and _shadow.unchanged(bladeRF_ShadowCache::FREQUENCY, direction, channel, "", frequency)) return;
+
+    //the gain tables depend on the band, so the gains change with the frequency
+    _shadow.invalidate(bladeRF_ShadowCache::FREQUENCY, direction);
+    _shadow.invalidate(bladeRF_ShadowCache::GAIN, direction);
     int ret = bladerf_set_frequency(_dev, _toch(direction, channel), bladerf_frequency(std::round(frequency)));
     if (ret != 0)
     {
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_frequency(%f) returned %s", frequency, _err2str(ret).c_str());
         throw std::runtime_error("setFrequency(RF) " + _err2str(ret));
     }
+    _shadow.set(bladeRF_ShadowCache::FREQUENCY, direction, channel, "", frequency);
 }
 
 double bladeRF_SoapySDR::getFrequency(const int direction, const size_t channel, const std::string &name) const
@@ -533,6 +670,12 @@ double bladeRF_SoapySDR::getFrequency(const int direction, const size_t channel,
     if (name == "BB") return 0.0; //for compatibility
     if (name != "RF") throw std::runtime_error("getFrequency("+name+") unknown name");
 
+    //not cached until the scheduled retunes have landed
+    const bool cacheable = not this->retunePending(direction);
+    double cached(0);
+    if (cacheable and _shadow.get(bladeRF_ShadowCache::FREQUENCY, direction, channel, "", cached)) return cached;
+
+    const unsigned long long epoch = _shadow.epoch();
     bladerf_frequency freq(0);
     int ret = bladerf_get_frequency(_dev, _toch(direction, channel), &freq);
     if (ret != 0)
@@ -540,6 +683,7 @@ double bladeRF_SoapySDR::getFrequency(const int direction, const size_t channel,
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_frequency() returned %s", _err2str(ret).c_str());
         throw std::runtime_error("getFrequency("+name+") " + _err2str(ret));
     }
+    if (cacheable) _shadow.put(bladeRF_ShadowCache::FREQUENCY, direction, channel, "", double(freq), epoch);
     return double(freq);
 }
 
@@ -553,6 +697,11 @@ SoapySDR::RangeList bladeRF_SoapySDR::getFrequencyRange(const int direction, con
     if (name == "BB") return SoapySDR::RangeList(1, SoapySDR::Range(0.0, 0.0)); //for compatibility
     if (name != "RF") throw std::runtime_error("getFrequencyRange("+name+") unknown name");
 
+    const auto caps = this->capabilities();
+    const auto chan = this->channelCapabilities(caps, direction, channel);
+    SoapySDR::Range cached;
+    if (chan != nullptr and findRange(chan->ranges, "frequency", cached)) return {cached};
+
     const bladerf_range* range(nullptr);
     int ret = bladerf_get_frequency_range(_dev, _toch(direction, channel), &range);
     if (ret != 0)
@@ -563,27 +712,31 @@ SoapySDR::RangeList bladeRF_SoapySDR::getFrequencyRange(const int direction, con
     return {toRange(range)};
 }
 
-bladerf_quick_tune* bladeRF_SoapySDR::getQuickTune(const int direction, const size_t channel) const
+bool bladeRF_SoapySDR::getQuickTune(const int direction, const size_t channel, bladerf_quick_tune &quickTune)
 {
-    bladerf_quick_tune* quick_tune = new bladerf_quick_tune();
     bladerf_channel ch = _toch(direction, channel);
-    int ret = bladerf_get_quick_tune(_dev, ch, quick_tune);
+    int ret = bladerf_get_quick_tune(_dev, ch, &quickTune);
 
     if (ret != 0)
     {
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_quick_tune() returned %s", _err2str(ret).c_str());
-        delete quick_tune;
-        return nullptr;
+        return false;
     }
 
-    return quick_tune;
+    //every call takes the next profile of the direction, even for a known frequency
+    _quickTuneProfiles[direction]++;
+    return true;
 }
 
-void bladeRF_SoapySDR::retune(const int direction, const size_t channel, long long timestamp, bladerf_quick_tune* quickTune)
+void bladeRF_SoapySDR::retune(const int direction, const size_t channel, long long timestamp, bladerf_quick_tune &quickTune)
 {
     bladerf_channel ch = _toch(direction, channel);
 
-    int ret = bladerf_schedule_retune(_dev, ch, timestamp, 0 /* frequency not needed for retune */, quickTune);
+    //the retune lands at the timestamp, the frequency is read from the device until it has
+    const long long timeNs = (timestamp == 0)? this->getHardwareTime("estimate") :
+        ((direction == SOAPY_SDR_RX)? _rxTicksToTimeNs(timestamp) : _txTicksToTimeNs(timestamp));
+    this->holdRetune(direction, timeNs);
+    int ret = bladerf_schedule_retune(_dev, ch, timestamp, 0 /* frequency not needed for retune */, &quickTune);
 
     if (ret != 0)
     {
@@ -592,47 +745,145 @@ void bladeRF_SoapySDR::retune(const int direction, const size_t channel, long lo
     }
 }
 
+void bladeRF_SoapySDR::holdRetune(const int direction, const long long timeNs)
+{
+    std::atomic<long long> &untilNs = (direction == SOAPY_SDR_RX)? _rxRetuneUntilNs : _txRetuneUntilNs;
+    const long long until = timeNs + RETUNE_SETTLE_NS;
+    long long current = untilNs.load();
+    while (current < until and not untilNs.compare_exchange_weak(current, until)) {}
+
+    //drop what was cached before the hold, reads racing this call are not stored
+    //the gains follow the frequency, the gain tables depend on the band
+    _shadow.invalidate(bladeRF_ShadowCache::FREQUENCY, direction);
+    _shadow.invalidate(bladeRF_ShadowCache::GAIN, direction);
+}
+
+bool bladeRF_SoapySDR::retunePending(const int direction) const
+{
+    std::atomic<long long> &untilNs = (direction == SOAPY_SDR_RX)? _rxRetuneUntilNs : _txRetuneUntilNs;
+    long long until = untilNs.load();
+    if (until == NO_RETUNE_NS) return false;
+    if (this->getHardwareTime("estimate") < until) return true;
+
+    //the retunes have landed, a value set while they were pending was overwritten by them
+    if (untilNs.compare_exchange_strong(until, NO_RETUNE_NS))
+    {
+        _shadow.invalidate(bladeRF_ShadowCache::FREQUENCY, direction);
+        _shadow.invalidate(bladeRF_ShadowCache::GAIN, direction);
+    }
+    return false;
+}
+
 /*******************************************************************
  * Sample Rate API
  ******************************************************************/
 
 void bladeRF_SoapySDR::setSampleRate(const int direction, const size_t channel, const double rate)
 {
+    if (_shadow.unchanged(bladeRF_ShadowCache::SAMPLE_RATE, direction, channel, "", rate)) return;
+
     bladerf_rational_rate ratRate;
     ratRate.integer = uint64_t(rate);
     ratRate.den = uint64_t(1 << 14); //arbitrary denominator -- should be big enough
-    ratRate.num = uint64_t(rate - ratRate.integer) * ratRate.den;
-
-    //stash the approximate hardware time so it can be restored
-    const long long timeNow = this->getHardwareTime();
-
-    int ret = bladerf_set_rational_sample_rate(_dev, _toch(direction, channel), &ratRate, NULL);
+    ratRate.num = uint64_t((rate - ratRate.integer) * ratRate.den);
+
+    //stash the approximate hardware time so it can be restored,
+    //the host clock carries it across the time the reprogramming takes
+    const long long timeBefore = this->getHardwareTime("estimate");
+    const auto hostBefore = bladeRF_TimeModel::Clock::now();
+    const auto timeNow = [timeBefore, hostBefore](void)
+    {
+        return timeBefore + (long long)(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            bladeRF_TimeModel::Clock::now() - hostBefore).count());
+    };
+
+    //the filters may follow the rate
+    //on bladeRF2 rx and tx share the clock chain, so the rate of the other direction moves too
+    _shadow.invalidate(bladeRF_ShadowCache::SAMPLE_RATE, direction);
+    _shadow.invalidate(bladeRF_ShadowCache::BANDWIDTH, direction);
+    if (_isBladeRF2) _shadow.invalidate(bladeRF_ShadowCache::SAMPLE_RATE, (direction == SOAPY_SDR_RX)?SOAPY_SDR_TX:SOAPY_SDR_RX);
+
+    bladerf_rational_rate actualRate;
+    int ret = bladerf_set_rational_sample_rate(_dev, _toch(direction, channel), &ratRate, &actualRate);
     if (ret != 0)
     {
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_rational_sample_rate(%f) returned %s", rate, _err2str(ret).c_str());
         throw std::runtime_error("setSampleRate() " + _err2str(ret));
     }
+    _shadow.set(bladeRF_ShadowCache::SAMPLE_RATE, direction, channel, "", rate);
 
-    //stash the actual rate
-    const double actual = this->getSampleRate(direction, channel);
-    if (direction == SOAPY_SDR_RX)
+    //the new rate continues the timeline from the tick count read right after the change,
+    //so only the ticks between the switch and the read are mapped at the old rate,
+    //on bladeRF2 the shared clock chain moves the counter of the other direction too
+    const double actual = double(actualRate.integer) + (double(actualRate.num)/double(actualRate.den));
+    for (const int dir : {SOAPY_SDR_RX, SOAPY_SDR_TX})
     {
-        _rxSampRate = actual;
-        this->updateRxMinTimeoutMs();
-    }
-    if (direction == SOAPY_SDR_TX)
-    {
-        _txSampRate = actual;
+        if (dir != direction and not _isBladeRF2) continue;
+
+        uint64_t ticksAfter = 0;
+        long long ticksNow = 0;
+        ret = bladerf_get_timestamp(_dev, (dir == SOAPY_SDR_RX)?BLADERF_RX:BLADERF_TX, &ticksAfter);
+        if (ret == 0) ticksNow = (long long)(ticksAfter);
+        else
+        {
+            SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_timestamp() returned %s", _err2str(ret).c_str());
+            ticksNow = (dir == SOAPY_SDR_RX)?_timeNsToRxTicks(timeNow()):_timeNsToTxTicks(timeNow());
+        }
+
+        //stash the actual rate, time conversions use the exact rational
+        this->setTickRate(dir, actualRate, ticksNow);
+        if (dir == SOAPY_SDR_RX)
+        {
+            _rxSampRate = actual;
+            this->updateRxMinTimeoutMs();
+        }
+        if (dir == SOAPY_SDR_TX)
+        {
+            _txSampRate = actual;
+        }
     }
 
-    //restore the previous hardware time setting (after rate stash)
-    this->setHardwareTime(timeNow);
+    //restore the hardware time as of now (after rate stash),
+    //unless the timeline was kept and the time counter keeps running
+    if (not _keepTimeline) this->setHardwareTime(timeNow());
 
     SoapySDR::logf(SOAPY_SDR_INFO, "setSampleRate(%s, %d, %f MHz), actual = %f MHz", direction==SOAPY_SDR_RX?"Rx":"Tx", int(channel), rate/1e6, actual/1e6);
 }
 
+void bladeRF_SoapySDR::setTickRate(const int direction, const bladerf_rational_rate &rate, const long long startTicks)
+{
+    //ticks per second = (integer*den + num)/den, reduced first so that a large den does not wrap
+    uint64_t num = rate.num;
+    uint64_t den = (rate.den == 0)? 1 : rate.den;
+    const uint64_t g = bladeRF_RationalScale::gcd(num, den);
+    num /= g;
+    den /= g;
+
+    //the ticks per den share no factor with den, so only 1e9 can cancel against them
+    const uint64_t limit = (1ull << 63) - 1; //the terms the scale keeps exactly
+    const bool fits = rate.integer <= (limit - num)/den;
+    const uint64_t ticksPerDen = fits? rate.integer*den + num : 0;
+    const uint64_t common = bladeRF_RationalScale::gcd(ticksPerDen, 1000000000ull);
+    const uint64_t nsPerSecond = 1000000000ull/common;
+    if (not fits or den > limit/nsPerSecond)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "setTickRate(%llu %llu/%llu) cannot be represented exactly",
+            (unsigned long long)(rate.integer), (unsigned long long)(rate.num), (unsigned long long)(rate.den));
+        throw std::runtime_error("setTickRate() rate out of range");
+    }
+    const uint64_t nsPerDen = nsPerSecond*den;
+    bladeRF_RationalScale toNs, toTicks;
+    toNs.set(nsPerDen, ticksPerDen/common);
+    toTicks.set(ticksPerDen/common, nsPerDen);
+    ((direction == SOAPY_SDR_RX)?_rxTimeline:_txTimeline).append(startTicks, toNs, toTicks);
+}
+
 double bladeRF_SoapySDR::getSampleRate(const int direction, const size_t channel) const
 {
+    double cached(0);
+    if (_shadow.get(bladeRF_ShadowCache::SAMPLE_RATE, direction, channel, "", cached)) return cached;
+
+    const unsigned long long epoch = _shadow.epoch();
     bladerf_rational_rate ratRate;
     int ret = bladerf_get_rational_sample_rate(_dev, _toch(direction, channel), &ratRate);
     if (ret != 0)
@@ -641,22 +892,30 @@ double bladeRF_SoapySDR::getSampleRate(const int direction, const size_t channel
         throw std::runtime_error("getSampleRate() " + _err2str(ret));
     }
 
-    return double(ratRate.integer) + (double(ratRate.num)/double(ratRate.den));
+    const double rate = double(ratRate.integer) + (double(ratRate.num)/double(ratRate.den));
+    _shadow.put(bladeRF_ShadowCache::SAMPLE_RATE, direction, channel, "", rate, epoch);
+    return rate;
 }
 
 SoapySDR::RangeList bladeRF_SoapySDR::getSampleRateRange(const int direction, const size_t channel) const
 {
-    const bladerf_range* range(nullptr);
-    int ret = bladerf_get_sample_rate_range(_dev, _toch(direction, channel), &range);
-    if (ret != 0)
+    const auto caps = this->capabilities();
+    const auto chan = this->channelCapabilities(caps, direction, channel);
+    SoapySDR::Range overallRange;
+    if (chan == nullptr or not findRange(chan->ranges, "sample_rate", overallRange))
     {
-        SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_sample_rate_range() returned %s", _err2str(ret).c_str());
-        throw std::runtime_error("getSampleRateRange() " + _err2str(ret));
+        const bladerf_range* range(nullptr);
+        int ret = bladerf_get_sample_rate_range(_dev, _toch(direction, channel), &range);
+        if (ret != 0)
+        {
+            SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_sample_rate_range() returned %s", _err2str(ret).c_str());
+            throw std::runtime_error("getSampleRateRange() " + _err2str(ret));
+        }
+        overallRange = toRange(range);
     }
 
     //create useful ranges based on the overall range
     //these values were suggested by the authors in the gr-osmosdr plugin for bladerf
-    const auto overallRange = toRange(range);
     SoapySDR::RangeList ranges;
     ranges.emplace_back(overallRange.minimum()/1.0, overallRange.maximum()/4.0, overallRange.maximum()/16.0);
     ranges.emplace_back(overallRange.maximum()/4.0, overallRange.maximum()/2.0, overallRange.maximum()/8.0);
@@ -684,10 +943,20 @@ std::vector<double> bladeRF_SoapySDR::listSampleRates(const int direction, const
 
 void bladeRF_SoapySDR::setBandwidth(const int direction, const size_t channel, const double bw)
 {
+    if (this->queueControl(CONTROL_BANDWIDTH, direction, channel, "", bw)) return;
+    this->setRfBandwidth(direction, channel, bw);
+}
+
+void bladeRF_SoapySDR::setRfBandwidth(const int direction, const size_t channel, const double bw)
+{
+    if (_shadow.unchanged(bladeRF_ShadowCache::BANDWIDTH, direction, channel, "", bw)) return;
+    _shadow.invalidate(bladeRF_ShadowCache::BANDWIDTH, direction);
+
     //bypass the filter when sufficiently large BW is selected
     if (bw > this->getBandwidthRange(direction, channel).back().maximum())
     {
         bladerf_set_lpf_mode(_dev, _toch(direction, channel), BLADERF_LPF_BYPASSED);
+        _shadow.set(bladeRF_ShadowCache::BANDWIDTH, direction, channel, "", bw);
         return;
     }
 
@@ -699,10 +968,15 @@ void bladeRF_SoapySDR::setBandwidth(const int direction, const size_t channel, c
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_set_bandwidth(%f) returned %s", bw, _err2str(ret).c_str());
         throw std::runtime_error("setBandwidth() " + _err2str(ret));
     }
+    _shadow.set(bladeRF_ShadowCache::BANDWIDTH, direction, channel, "", bw);
 }
 
 double bladeRF_SoapySDR::getBandwidth(const int direction, const size_t channel) const
 {
+    double cached(0);
+    if (_shadow.get(bladeRF_ShadowCache::BANDWIDTH, direction, channel, "", cached)) return cached;
+
+    const unsigned long long epoch = _shadow.epoch();
     bladerf_bandwidth bw(0);
     int ret = bladerf_get_bandwidth(_dev, _toch(direction, channel), &bw);
     if (ret != 0)
@@ -710,11 +984,17 @@ double bladeRF_SoapySDR::getBandwidth(const int direction, const size_t channel)
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_get_bandwidth() returned %s", _err2str(ret).c_str());
         throw std::runtime_error("getBandwidth() " + _err2str(ret));
     }
+    _shadow.put(bladeRF_ShadowCache::BANDWIDTH, direction, channel, "", double(bw), epoch);
     return double(bw);
 }
 
 SoapySDR::RangeList bladeRF_SoapySDR::getBandwidthRange(const int direction, const size_t channel) const
 {
+    const auto caps = this->capabilities();
+    const auto chan = this->channelCapabilities(caps, direction, channel);
+    SoapySDR::Range cached;
+    if (chan != nullptr and findRange(chan->ranges, "bandwidth", cached)) return {cached};
+
     const bladerf_range* range(nullptr);
     int ret = bladerf_get_bandwidth_range(_dev, _toch(direction, channel), &range);
     if (ret != 0)
@@ -743,6 +1023,116 @@ std::vector<double> bladeRF_SoapySDR::listBandwidths(const int direction, const
     return options;
 }
 
+/*******************************************************************
+ * Async control
+ ******************************************************************/
+
+bool bladeRF_SoapySDR::queueControl(const ControlParam param, const int direction, const size_t channel, const std::string &name, const double value)
+{
+    std::lock_guard<std::mutex> lock(_controlMutex);
+    if (not _asyncControl) return false;
+
+    //a newer value replaces the pending one, only the latest is applied
+    _controlChanges[std::make_tuple(int(param), direction, channel, name)] = std::make_pair(value, ++_controlQueued);
+    _controlCond.notify_all();
+    return true;
+}
+
+void bladeRF_SoapySDR::applyControl(const ControlParam param, const int direction, const size_t channel, const std::string &name, const double value)
+{
+    switch (param)
+    {
+    case CONTROL_FREQUENCY: this->setRfFrequency(direction, channel, value); break;
+    case CONTROL_BANDWIDTH: this->setRfBandwidth(direction, channel, value); break;
+    case CONTROL_GAIN: this->setRfGain(direction, channel, name, value); break;
+    }
+}
+
+void bladeRF_SoapySDR::controlThreadLoop(void)
+{
+    std::unique_lock<std::mutex> lock(_controlMutex);
+    while (true)
+    {
+        _controlCond.wait(lock, [this](void){return not _controlChanges.empty() or not _asyncControl;});
+
+        //stopping drains the queue first
+        if (_controlChanges.empty()) break;
+
+        //take the whole batch, changes queued meanwhile wait for the next pass
+        _controlApplying.swap(_controlChanges);
+        lock.unlock();
+
+        //apply in call order, an overall gain and its stages must end up as in synchronous mode
+        std::vector<ControlChanges::const_iterator> ordered;
+        for (auto it = _controlApplying.cbegin(); it != _controlApplying.cend(); ++it) ordered.push_back(it);
+        std::sort(ordered.begin(), ordered.end(), [](const ControlChanges::const_iterator &a, const ControlChanges::const_iterator &b)
+        {
+            return a->second.second < b->second.second;
+        });
+
+        unsigned long long applied = 0;
+        unsigned long long errors = 0;
+        std::string lastError;
+        for (const auto &change : ordered)
+        {
+            try
+            {
+                this->applyControl(ControlParam(std::get<0>(change->first)), std::get<1>(change->first),
+                    std::get<2>(change->first), std::get<3>(change->first), change->second.first);
+            }
+            catch (const std::exception &ex)
+            {
+                errors++;
+                lastError = ex.what();
+            }
+            applied = std::max(applied, change->second.second);
+        }
+
+        //every change up to the highest sequence number in the batch was applied or replaced
+        lock.lock();
+        _controlApplying.clear();
+        _controlApplied = applied;
+        _controlErrors += errors;
+        if (not lastError.empty()) _controlLastError = lastError;
+        _controlCond.notify_all();
+    }
+}
+
+void bladeRF_SoapySDR::drainControl(const int direction, const size_t channel)
+{
+    std::unique_lock<std::mutex> lock(_controlMutex);
+
+    //the latest change of the channel, whether it waits in the queue or is being applied
+    unsigned long long last = 0;
+    for (const ControlChanges *changes : {&_controlChanges, &_controlApplying})
+    {
+        for (const auto &change : *changes)
+        {
+            if (std::get<1>(change.first) != direction or std::get<2>(change.first) != channel) continue;
+            last = std::max(last, change.second.second);
+        }
+    }
+    _controlCond.wait(lock, [this, last](void){return _controlApplied >= last;});
+}
+
+void bladeRF_SoapySDR::startControlThread(void)
+{
+    std::lock_guard<std::mutex> lock(_controlMutex);
+    if (_asyncControl) return;
+    _asyncControl = true;
+    _controlThread = std::thread(&bladeRF_SoapySDR::controlThreadLoop, this);
+}
+
+void bladeRF_SoapySDR::stopControlThread(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        _asyncControl = false;
+        _controlCond.notify_all();
+    }
+    if (_controlThread.joinable()) _controlThread.join();
+}
+
 /*******************************************************************
  * Clocking API
  ******************************************************************/
@@ -838,15 +1228,29 @@ std::string bladeRF_SoapySDR::getClockSource(void) const
 
 bool bladeRF_SoapySDR::hasHardwareTime(const std::string &what) const
 {
+    if (what == "estimate") return true;
     if (not what.empty()) return SoapySDR::Device::hasHardwareTime(what);
     return true;
 }
 
 long long bladeRF_SoapySDR::getHardwareTime(const std::string &what) const
 {
+    //the estimate extrapolates the last reads with the host clock,
+    //the device is only read when the model has not been refreshed recently
+    if (what == "estimate")
+    {
+        const auto hostTime = bladeRF_TimeModel::Clock::now();
+        long long timeNs = 0;
+        if (_timeModel.fresh(hostTime, std::chrono::seconds(1)) and _timeModel.toTimeNs(hostTime, timeNs)) return timeNs;
+        return this->getHardwareTime();
+    }
     if (not what.empty()) return SoapySDR::Device::getHardwareTime(what);
+
+    //the midpoint of the transfer is the best guess for when the counter was sampled
     uint64_t ticksNow = 0;
+    const auto before = bladeRF_TimeModel::Clock::now();
     const int ret = bladerf_get_timestamp(_dev, BLADERF_RX, &ticksNow);
+    const auto after = bladeRF_TimeModel::Clock::now();
 
     if (ret != 0)
     {
@@ -854,7 +1258,9 @@ long long bladeRF_SoapySDR::getHardwareTime(const std::string &what) const
         throw std::runtime_error("getHardwareTime() " + _err2str(ret));
     }
 
-    return _rxTicksToTimeNs(ticksNow);
+    const long long timeNs = _rxTicksToTimeNs(ticksNow);
+    _timeModel.update(before + (after - before)/2, timeNs);
+    return timeNs;
 }
 
 void bladeRF_SoapySDR::setHardwareTime(const long long timeNs, const std::string &what)
@@ -877,7 +1283,11 @@ void bladeRF_SoapySDR::setHardwareTime(const long long timeNs, const std::string
         throw std::runtime_error("setHardwareTime() " + _err2str(ret));
     }
 
+    //both counters restarted from zero at their current rates
+    _rxTimeline.restart();
+    _txTimeline.restart();
     _timeNsOffset = timeNs;
+    _timeModel.set(bladeRF_TimeModel::Clock::now(), timeNs);
 }
 
 /*******************************************************************
@@ -888,6 +1298,8 @@ std::vector<std::string> bladeRF_SoapySDR::listSensors(void) const
 {
     std::vector<std::string> sensors;
     if (_isBladeRF2) sensors.push_back("RFIC_TEMP");
+    sensors.push_back("CONTROL_PENDING");
+    sensors.push_back("CONTROL_STATUS");
     return sensors;
 }
 
@@ -904,6 +1316,29 @@ SoapySDR::ArgInfo bladeRF_SoapySDR::getSensorInfo(const std::string &key) const
         info.type = SoapySDR::ArgInfo::FLOAT;
         return info;
     }
+    else if (key == "CONTROL_PENDING")
+    {
+        SoapySDR::ArgInfo info;
+        info.key = key;
+        info.value = "0";
+        info.name = "Pending Control Changes";
+        info.description = "Settings changes queued in async control mode that the control thread has not applied yet, including the batch it is applying. "
+            "A change replaced by a newer value counts until the newer one is applied";
+        info.type = SoapySDR::ArgInfo::INT;
+        return info;
+    }
+    else if (key == "CONTROL_STATUS")
+    {
+        SoapySDR::ArgInfo info;
+        info.key = key;
+        info.value = "";
+        info.name = "Control Status";
+        info.description = "Async control progress as key=value pairs: "
+            "queued and applied are sequence numbers, a change is complete once applied reaches "
+            "the queued value read after making it; errors counts the changes that failed";
+        info.type = SoapySDR::ArgInfo::STRING;
+        return info;
+    }
     else throw std::runtime_error("getSensorInfo(" + key + ") unknown sensor");
 }
 
@@ -920,6 +1355,23 @@ std::string bladeRF_SoapySDR::readSensor(const std::string &key) const
         }
         return std::to_string(val);
     }
+    else if (key == "CONTROL_PENDING")
+    {
+        //the batch being applied has left the queue but is not applied yet
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        return std::to_string(_controlQueued - _controlApplied);
+    }
+    else if (key == "CONTROL_STATUS")
+    {
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        SoapySDR::Kwargs status;
+        status["queued"] = std::to_string(_controlQueued);
+        status["applied"] = std::to_string(_controlApplied);
+        status["pending"] = std::to_string(_controlQueued - _controlApplied);
+        status["errors"] = std::to_string(_controlErrors);
+        if (not _controlLastError.empty()) status["last_error"] = _controlLastError;
+        return SoapySDR::KwargsToString(status);
+    }
     else throw std::runtime_error("readSensor(" + key + ") unknown sensor");
 }
 
@@ -928,6 +1380,9 @@ std::vector<std::string> bladeRF_SoapySDR::listSensors(const int direction, cons
     std::vector<std::string> sensors;
     if (_isBladeRF2 and direction == SOAPY_SDR_RX) sensors.push_back("PRE_RSSI");
     if (_isBladeRF2 and direction == SOAPY_SDR_RX) sensors.push_back("SYM_RSSI");
+    if (direction == SOAPY_SDR_RX) sensors.push_back("DROPPED_SAMPLES");
+    if (direction == SOAPY_SDR_RX) sensors.push_back("RX_LATENCY_US");
+    if (direction == SOAPY_SDR_RX) sensors.push_back("RX_LATENCY_STATS");
     return sensors;
 }
 
@@ -955,6 +1410,41 @@ SoapySDR::ArgInfo bladeRF_SoapySDR::getSensorInfo(const int direction, const siz
         info.type = SoapySDR::ArgInfo::FLOAT;
         return info;
     }
+    else if (key == "DROPPED_SAMPLES" and direction == SOAPY_SDR_RX)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = key;
+        info.value = "0";
+        info.name = "Dropped Samples";
+        info.description = "Samples per channel lost to overflows since the stream was set up, "
+            "measured from the gaps in the received timestamps";
+        info.units = "samples";
+        info.type = SoapySDR::ArgInfo::INT;
+        return info;
+    }
+    else if (key == "RX_LATENCY_US" and direction == SOAPY_SDR_RX)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = key;
+        info.value = "0";
+        info.name = "RX Latency";
+        info.description = "How far behind the device time the last samples reached the application, "
+            "from the time of their first sample";
+        info.units = "us";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        return info;
+    }
+    else if (key == "RX_LATENCY_STATS" and direction == SOAPY_SDR_RX)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = key;
+        info.value = "";
+        info.name = "RX Latency Statistics";
+        info.description = "RX latency since the stream was activated: "
+            "count, last, min, max, p50, p90, p99 and p999 as key=value pairs in microseconds";
+        info.type = SoapySDR::ArgInfo::STRING;
+        return info;
+    }
     else throw std::runtime_error("getSensorInfo(" + key + ") unknown sensor");
 }
 
@@ -971,6 +1461,30 @@ std::string bladeRF_SoapySDR::readSensor(const int direction, const size_t chann
         }
         return std::to_string((key[0] == 'P')?pre_rssi:sym_rssi);
     }
+    else if (key == "DROPPED_SAMPLES" and direction == SOAPY_SDR_RX)
+    {
+        return std::to_string(_rx.droppedSamples.load());
+    }
+    else if (key == "RX_LATENCY_US" and direction == SOAPY_SDR_RX)
+    {
+        return std::to_string(_rx.latency.last()/1e3);
+    }
+    else if (key == "RX_LATENCY_STATS" and direction == SOAPY_SDR_RX)
+    {
+        //reading the statistics keeps the time model that the latency is measured against fresh
+        if (not _timeModel.fresh(bladeRF_TimeModel::Clock::now(), std::chrono::seconds(1))) this->getHardwareTime();
+
+        SoapySDR::Kwargs stats;
+        stats["count"] = std::to_string(_rx.latency.count());
+        stats["last"] = std::to_string(_rx.latency.last()/1e3);
+        stats["min"] = std::to_string(_rx.latency.min()/1e3);
+        stats["max"] = std::to_string(_rx.latency.max()/1e3);
+        stats["p50"] = std::to_string(_rx.latency.percentile(0.5)/1e3);
+        stats["p90"] = std::to_string(_rx.latency.percentile(0.9)/1e3);
+        stats["p99"] = std::to_string(_rx.latency.percentile(0.99)/1e3);
+        stats["p999"] = std::to_string(_rx.latency.percentile(0.999)/1e3);
+        return SoapySDR::KwargsToString(stats);
+    }
     else throw std::runtime_error("readSensor(" + key + ") unknown sensor");
 }
 
@@ -1099,12 +1613,10 @@ SoapySDR::ArgInfoList bladeRF_SoapySDR::getSettingInfo(void) const
     lookbackArg.name = "Loopback Mode";
     lookbackArg.description = "Enable/disable internal loopback";
     lookbackArg.type = SoapySDR::ArgInfo::STRING;
-    const bladerf_loopback_modes *modes(nullptr);
-    const int numModes = bladerf_get_loopback_modes(_dev, &modes);
-    if (modes and numModes > 0) for (int i = 0; i < numModes; i++)
+    for (const auto &mode : this->capabilities()->loopbackModes)
     {
-        if (modes[i].mode == BLADERF_LB_NONE) lookbackArg.value = modes[i].name;
-        lookbackArg.options.push_back(modes[i].name);
+        if (mode.second == BLADERF_LB_NONE) lookbackArg.value = mode.first;
+        lookbackArg.options.push_back(mode.first);
     }
 
     setArgs.push_back(lookbackArg);
@@ -1209,6 +1721,37 @@ SoapySDR::ArgInfoList bladeRF_SoapySDR::getSettingInfo(void) const
 
     setArgs.push_back(biasTeeRx);
 
+    // Keep the timeline across sample rate changes
+    SoapySDR::ArgInfo keepTimelineArg;
+    keepTimelineArg.key = "keep_timeline";
+    keepTimelineArg.value = "false";
+    keepTimelineArg.name = "Keep Timeline";
+    keepTimelineArg.description = "Keep the time counter running when the sample rate changes, so scheduled timestamps stay valid. "
+        "Otherwise the counter is reset to the approximate current time after every rate change.";
+    keepTimelineArg.type = SoapySDR::ArgInfo::BOOL;
+    keepTimelineArg.options.push_back("true");
+    keepTimelineArg.optionNames.push_back("True");
+    keepTimelineArg.options.push_back("false");
+    keepTimelineArg.optionNames.push_back("False");
+
+    setArgs.push_back(keepTimelineArg);
+
+    // Apply frequency, gain and bandwidth changes on a control thread
+    SoapySDR::ArgInfo asyncControlArg;
+    asyncControlArg.key = "async_control";
+    asyncControlArg.value = "false";
+    asyncControlArg.name = "Async Control";
+    asyncControlArg.description = "Queue setFrequency, setGain and setBandwidth to a control thread and return at once. "
+        "Only the latest value per direction, channel and setting is applied, progress is reported by the CONTROL_STATUS sensor. "
+        "Disabling waits for the queued changes to be applied.";
+    asyncControlArg.type = SoapySDR::ArgInfo::BOOL;
+    asyncControlArg.options.push_back("true");
+    asyncControlArg.optionNames.push_back("True");
+    asyncControlArg.options.push_back("false");
+    asyncControlArg.optionNames.push_back("False");
+
+    setArgs.push_back(asyncControlArg);
+
     return setArgs;
 }
 
@@ -1221,11 +1764,9 @@ std::string bladeRF_SoapySDR::readSetting(const std::string &key) const
     } else if (key == "loopback") {
         bladerf_loopback lb;
         bladerf_get_loopback(_dev, &lb);
-        const bladerf_loopback_modes *modes(nullptr);
-        const int numModes = bladerf_get_loopback_modes(_dev, &modes);
-        if (modes and numModes > 0) for (int i = 0; i < numModes; i++)
+        for (const auto &mode : this->capabilities()->loopbackModes)
         {
-            if (modes[i].mode == lb) return modes[i].name;
+            if (mode.second == lb) return mode.first;
         }
         return "unknown";
     } else if (key == "reset") {
@@ -1244,6 +1785,11 @@ std::string bladeRF_SoapySDR::readSetting(const std::string &key) const
         return "false";
     } else if (key == "biastee_rx") {
         return "false";
+    } else if (key == "keep_timeline") {
+        return _keepTimeline ? "true" : "false";
+    } else if (key == "async_control") {
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        return _asyncControl ? "true" : "false";
     } else if (key == "oversample") {
         bladerf_feature feature;
         int ret = bladerf_get_feature(_dev, &feature);
@@ -1268,6 +1814,7 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
         {
             // --> Valid setting has arrived
             _xb200Mode = value;
+            _shadow.clear(); //the transverter shifts the tuned frequency
 
             // Get attached expansion device
             bladerf_xb _bladerf_xb_attached = bladerf_xb::BLADERF_XB_NONE;
@@ -1296,6 +1843,7 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
                 }
             }
             SoapySDR::logf(SOAPY_SDR_INFO, "bladeRF: XB200 is attached");
+            this->snapshotCapabilities(); //the frequency range extends through the transverter
 
             // Which filterbank was selected?
             bladerf_xb200_filter filter = bladerf_xb200_filter::BLADERF_XB200_AUTO_1DB;
@@ -1383,6 +1931,7 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
         {
             // --> Valid setting has arrived
             _samplingMode = value;
+            _shadow.clear();
 
             // Set the sampling mode
             int ret = 0;
@@ -1414,11 +1963,9 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
     else if (key == "loopback")
     {
         bladerf_loopback loopback(BLADERF_LB_NONE);
-        const bladerf_loopback_modes *modes(nullptr);
-        const int numModes = bladerf_get_loopback_modes(_dev, &modes);
-        if (modes and numModes > 0) for (int i = 0; i < numModes; i++)
+        for (const auto &mode : this->capabilities()->loopbackModes)
         {
-            if (modes[i].name == value) loopback = modes[i].mode;
+            if (mode.first == value) loopback = mode.second;
         }
         if (bladerf_is_loopback_mode_supported(_dev, loopback))
         {
@@ -1428,6 +1975,7 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
             if (_bladerf_loopback != loopback)
             {
                 SoapySDR::logf(SOAPY_SDR_INFO, "bladeRF: Loopback set '%s'", value.c_str());
+                _shadow.clear(); //the loopback paths reconfigure the rf front end
                 int ret = bladerf_set_loopback(_dev, loopback);
                 if (ret != 0)
                 {
@@ -1448,6 +1996,7 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
         // Verify that a valid setting has arrived
         if (value == "true") {
             // --> Valid setting has arrived
+            _shadow.clear();
             int ret = bladerf_device_reset(_dev);
             if (ret != 0)
             {
@@ -1530,12 +2079,15 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
     else if (key == "load_fpga")
     {
         if (!value.empty()) {
+            _shadow.clear();
+            this->clearQuickTunes(); //loading the fpga resets the quick tune profiles
             int ret = bladerf_load_fpga(_dev, value.c_str());
             if (ret != 0) {
                 SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_load_fpga(%s) returned %s", value.c_str(),
                                _err2str(ret).c_str());
                 throw std::runtime_error("writeSetting() " + _err2str(ret));
             }
+            this->snapshotCapabilities(); //the fpga decides the versions, agc and ranges
         }
         /*else {
             // --> Invalid setting has arrived
@@ -1570,8 +2122,21 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
             }
         }
     }
+    else if (key == "keep_timeline")
+    {
+        if (value == "true" || value == "false") {
+            // --> Valid setting has arrived
+            _keepTimeline = (value == "true");
+        }
+    }
+    else if (key == "async_control")
+    {
+        if (value == "true") this->startControlThread();
+        if (value == "false") this->stopControlThread();
+    }
     else if (key == "oversample") {
         bool enable = (value == "true");
+        _shadow.clear();
         int ret = bladerf_enable_feature(_dev, BLADERF_FEATURE_OVERSAMPLE, enable);
         if (ret != 0)
         {
@@ -1580,10 +2145,12 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
             throw std::runtime_error("writeSetting() " + _err2str(ret));
         }
         SoapySDR::logf(SOAPY_SDR_INFO, "bladerf_enable_feature(OVERSAMPLE, %s)", value.c_str());
+        this->snapshotCapabilities(); //oversampling extends the sample rate range
     }
     else if (key == "feature")
     {
         bool enable = (value == "oversample");
+        _shadow.clear();
         int ret = bladerf_enable_feature(_dev, BLADERF_FEATURE_OVERSAMPLE, enable);
         if (ret != 0)
         {
@@ -1592,6 +2159,7 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
             throw std::runtime_error("writeSetting() " + _err2str(ret));
         }
         SoapySDR::logf(SOAPY_SDR_INFO, "bladerf_enable_feature(OVERSAMPLE, %s)", enable ? "true" : "false");
+        this->snapshotCapabilities(); //oversampling extends the sample rate range
     }
     else
     {
@@ -1599,6 +2167,68 @@ void bladeRF_SoapySDR::writeSetting(const std::string &key, const std::string &v
     }
 }
 
+SoapySDR::ArgInfoList bladeRF_SoapySDR::getSettingInfo(const int, const size_t) const
+{
+    SoapySDR::ArgInfoList setArgs;
+    if (!_isBladeRF2) return setArgs; //quick tunes are only available for BladeRF2
+
+    SoapySDR::ArgInfo hopPlanArg;
+    hopPlanArg.key = "hop_plan";
+    hopPlanArg.value = "";
+    hopPlanArg.name = "Hop Plan";
+    hopPlanArg.description = "Comma separated frequencies in Hz to hop through. "
+        "Each new frequency is tuned once to store its quick tune profile, which stays until the FPGA is loaded again. "
+        "There are 256 profiles per direction.";
+    hopPlanArg.units = "Hz";
+    hopPlanArg.type = SoapySDR::ArgInfo::STRING;
+
+    setArgs.push_back(hopPlanArg);
+
+    SoapySDR::ArgInfo hopScheduleArg;
+    hopScheduleArg.key = "hop_schedule";
+    hopScheduleArg.value = "";
+    hopScheduleArg.name = "Hop Schedule";
+    hopScheduleArg.description = "Hop through the plan as key=value pairs: start is the hardware time of the first hop in ns "
+        "(default shortly after now), dwell is the time per hop in ns, count is the number of hops "
+        "(default one pass through the plan, 0 hops until cancelled). An empty value cancels the hops. "
+        "Reading reports the progress.";
+    hopScheduleArg.type = SoapySDR::ArgInfo::STRING;
+
+    setArgs.push_back(hopScheduleArg);
+
+    return setArgs;
+}
+
+void bladeRF_SoapySDR::writeSetting(const int direction, const size_t channel, const std::string &key, const std::string &value)
+{
+    if (!_isBladeRF2 and (key == "hop_plan" or key == "hop_schedule"))
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "%s is only available for BladeRF2.", key.c_str());
+        throw std::runtime_error(key + " is only available for BladeRF2.");
+    }
+
+    if (key == "hop_plan") this->setHopPlan(direction, channel, value);
+    else if (key == "hop_schedule") this->setHopSchedule(direction, channel, value);
+    else throw std::runtime_error("writeSetting(" + key + ") unknown setting");
+}
+
+std::string bladeRF_SoapySDR::readSetting(const int direction, const size_t channel, const std::string &key) const
+{
+    if (key == "hop_plan")
+    {
+        std::string plan;
+        const auto it = _hopPlans.find(std::make_pair(direction, channel));
+        if (it != _hopPlans.end()) for (const auto freq : it->second)
+        {
+            if (not plan.empty()) plan += ",";
+            plan += std::to_string(freq);
+        }
+        return plan;
+    }
+    else if (key == "hop_schedule") return this->getHopSchedule(direction, channel);
+    else throw std::runtime_error("readSetting(" + key + ") unknown setting");
+}
+
 /*******************************************************************
  * GPIO API
  ******************************************************************/
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <mutex>
+#include <map>
+#include <tuple>
+#include <string>
+
+/*!
+ * Write-through cache of the device settings.
+ * Values read back from the device serve the following reads, and the
+ * last value set is kept so that setting the same value again is skipped.
+ * Setting a parameter drops its entries for every channel of the direction,
+ * because the channels share the LO, the sample clock and the filters.
+ * The caller and the control thread may use it concurrently.
+ */
+class bladeRF_ShadowCache
+{
+public:
+    enum Param
+    {
+        FREQUENCY,
+        BANDWIDTH,
+        GAIN,
+        GAIN_MODE,
+        SAMPLE_RATE,
+    };
+
+    bladeRF_ShadowCache(void):
+        _epoch(0)
+    {
+        return;
+    }
+
+    //! take the epoch before reading the device, and pass it to put()
+    unsigned long long epoch(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _epoch;
+    }
+
+    //! the cached read back value, false when it must be read from the device
+    bool get(const Param param, const int direction, const size_t channel, const std::string &name, double &value) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _read.find(Key(param, direction, channel, name));
+        if (it == _read.end()) return false;
+        value = it->second;
+        return true;
+    }
+
+    //! store a value read back from the device, unless a set or invalidation raced the read
+    void put(const Param param, const int direction, const size_t channel, const std::string &name, const double value, const unsigned long long epoch)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (epoch != _epoch) return;
+        _read[Key(param, direction, channel, name)] = value;
+    }
+
+    //! true when value is what was last set, so the device already has it
+    bool unchanged(const Param param, const int direction, const size_t channel, const std::string &name, const double value) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _written.find(Key(param, direction, channel, name));
+        return it != _written.end() and it->second == value;
+    }
+
+    //! record a successful set, the device may have adjusted the value so it is read back again
+    void set(const Param param, const int direction, const size_t channel, const std::string &name, const double value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        this->erase(param, direction);
+        _written[Key(param, direction, channel, name)] = value;
+    }
+
+    //! drop the entries of a parameter in one direction
+    void invalidate(const Param param, const int direction)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        this->erase(param, direction);
+    }
+
+    //! drop everything, the device state changed behind the cache
+    void clear(void)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _epoch++;
+        _read.clear();
+        _written.clear();
+    }
+
+private:
+    typedef std::tuple<int, int, size_t, std::string> Key;
+
+    void erase(const Param param, const int direction)
+    {
+        _epoch++;
+        eraseRange(_read, param, direction);
+        eraseRange(_written, param, direction);
+    }
+
+    //! the keys are ordered by parameter then direction, so the entries are contiguous
+    static void eraseRange(std::map<Key, double> &entries, const Param param, const int direction)
+    {
+        auto it = entries.lower_bound(Key(param, direction, 0, ""));
+        while (it != entries.end() and std::get<0>(it->first) == param and std::get<1>(it->first) == direction)
+        {
+            it = entries.erase(it);
+        }
+    }
+
+    mutable std::mutex _mutex;
+    unsigned long long _epoch;
+    std::map<Key, double> _read;
+    std::map<Key, double> _written;
+};
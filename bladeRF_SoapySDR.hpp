@@ -21,11 +21,25 @@
 
 #pragma once
 
+#include "bladeRF_TimeModel.hpp"
+#include "bladeRF_LatencyStats.hpp"
+#include "bladeRF_Timeline.hpp"
+#include "bladeRF_ShadowCache.hpp"
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Time.hpp>
 #include <libbladeRF.h>
 #include <cstdio>
 #include <queue>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+class bladeRF_AsyncStream;
+struct StreamConverter;
+template <typename T> class bladeRF_RingBuffer;
 
 #if defined(LIBBLADERF_API_VERSION) && (LIBBLADERF_API_VERSION >= 0x02000000)
 #else
@@ -33,7 +47,7 @@
 #endif
 
 /*!
- * Storage for rx commands and tx responses
+ * Storage for rx commands, rx status events and tx responses
  */
 struct StreamMetadata
 {
@@ -43,6 +57,209 @@ struct StreamMetadata
     int code;
 };
 
+/*!
+ * A block of wire samples queued between a streaming thread and the caller.
+ * The status code is reported to the caller ahead of the samples.
+ */
+struct StreamBlock
+{
+    std::vector<int16_t> samples;
+    size_t numElems;
+    long long ticks;
+    int flags;
+    int code;
+};
+
+/*!
+ * How the samples missing from a gap in the rx timestamps are synthesized
+ */
+enum GapFillMode
+{
+    GAP_FILL_NONE,
+    GAP_FILL_ZEROS,
+    GAP_FILL_HOLD,
+};
+
+/*!
+ * The settings that the control thread applies in async control mode,
+ * changes are applied in this order so that gains follow the tuning
+ */
+enum ControlParam
+{
+    CONTROL_FREQUENCY,
+    CONTROL_BANDWIDTH,
+    CONTROL_GAIN,
+};
+
+/*!
+ * Settings changes waiting for the control thread.
+ * The key is (parameter, direction, channel, gain stage name),
+ * the value is the latest requested value and its sequence number.
+ * A batch is applied in sequence order, the map order would reorder the gain stages.
+ */
+typedef std::map<std::tuple<int, int, size_t, std::string>, std::pair<double, unsigned long long>> ControlChanges;
+
+/*!
+ * A sequence of quick tune hops that the hop thread feeds to the fpga retune queue.
+ * Hop i retunes to hops[i % hops.size()] at startNs + i*dwellNs.
+ */
+struct HopSchedule
+{
+    std::vector<bladerf_quick_tune> hops;
+    long long startNs;
+    long long dwellNs;
+    size_t count; //0 hops until cancelled
+    size_t next;
+    size_t missed;
+    size_t errors;
+};
+
+/*!
+ * What a channel supports, probed once instead of on every query.
+ * A range is missing when the probe failed, the query then asks the device.
+ */
+struct ChannelCapabilities
+{
+    bool gainMode;
+    bool gainsListed;
+    std::vector<std::string> gains;
+
+    //! the "frequency", "sample_rate" and "bandwidth" ranges
+    //! the gain ranges are not kept, on bladeRF2 they depend on the frequency band
+    std::map<std::string, SoapySDR::Range> ranges;
+};
+
+/*!
+ * Snapshot of the device capabilities, taken when the device is opened
+ * and again after a setting that changes them, such as loading the FPGA.
+ */
+struct DeviceCapabilities
+{
+    SoapySDR::Kwargs hardwareInfo;
+    std::vector<std::pair<std::string, bladerf_loopback>> loopbackModes;
+    std::vector<ChannelCapabilities> rx;
+    std::vector<ChannelCapabilities> tx;
+};
+
+/*!
+ * The state of a stream in either direction.
+ * Each direction owns its context and the stream handle points to it,
+ * so rx and tx share no mutable state and can each have their own format.
+ */
+struct StreamContext
+{
+    StreamContext(const int direction):
+        direction(direction),
+        format(BLADERF_FORMAT_SC16_Q11_META),
+        converter(nullptr),
+        buffSize(0),
+        batch(false),
+        hostSampleSize(0),
+        nextTicks(0),
+        async(nullptr),
+        asyncHandle(0),
+        asyncOffset(0),
+        ring(nullptr),
+        threadRunning(false)
+    {
+        return;
+    }
+
+    const int direction;
+
+    //! the wire format and the converter to and from the host format
+    bladerf_format format;
+    const StreamConverter *converter;
+
+    std::vector<size_t> chans;
+
+    //! wire samples for one buffer when the host format needs conversion
+    std::vector<int16_t> convBuff;
+    size_t buffSize;
+    bool batch;
+    size_t hostSampleSize;
+    long long nextTicks;
+
+    //! direct buffer access through the async interface
+    bladeRF_AsyncStream *async;
+    size_t asyncHandle;
+    size_t asyncOffset;
+
+    //! threaded streaming through a ring of blocks
+    bladeRF_RingBuffer<StreamBlock> *ring;
+    std::thread thread;
+    std::atomic<bool> threadRunning;
+};
+
+struct RxStreamContext : StreamContext
+{
+    RxStreamContext(void):
+        StreamContext(SOAPY_SDR_RX),
+        overflow(false),
+        minTimeoutMs(0),
+        asyncRemaining(0),
+        ringOffset(0),
+        expectTicks(-1),
+        droppedSamples(0),
+        gapFill(GAP_FILL_NONE),
+        gapMax(0),
+        fillTicks(-1),
+        pendingTicks(0),
+        pendingOffset(0),
+        pendingElems(0),
+        pendingFlags(0)
+    {
+        return;
+    }
+
+    bool overflow;
+    long minTimeoutMs;
+    std::queue<StreamMetadata> cmds;
+    size_t asyncRemaining;
+    size_t ringOffset;
+
+    //! timestamp accounting and statistics
+    long long expectTicks;
+    std::atomic<unsigned long long> droppedSamples;
+    bladeRF_LatencyStats latency;
+
+    //! status events for readStreamStatus
+    std::queue<StreamMetadata> events;
+    std::mutex eventMutex;
+    std::condition_variable eventCond;
+
+    //! gap filling and the received samples held behind a fill
+    GapFillMode gapFill;
+    long long gapMax;
+    long long fillTicks;
+    std::vector<char> holdSample;
+    long long pendingTicks;
+    size_t pendingOffset;
+    size_t pendingElems;
+    int pendingFlags;
+};
+
+struct TxStreamContext : StreamContext
+{
+    TxStreamContext(void):
+        StreamContext(SOAPY_SDR_TX),
+        inBurst(false),
+        asyncAcquired(false),
+        ringFill(0)
+    {
+        return;
+    }
+
+    bool inBurst;
+    bool asyncAcquired;
+    size_t ringFill;
+
+    //! status responses for readStreamStatus
+    std::queue<StreamMetadata> resps;
+    std::mutex respMutex;
+    std::condition_variable respCond;
+};
+
 /*!
  * The SoapySDR device interface for a blade RF.
  * The overloaded virtual methods calls into the blade RF C API.
@@ -132,6 +349,39 @@ public:
         const long timeoutUs
     );
 
+    /*******************************************************************
+     * Direct buffer access API
+     ******************************************************************/
+
+    size_t getNumDirectAccessBuffers(SoapySDR::Stream *stream);
+
+    int getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const size_t handle, void **buffs);
+
+    int acquireReadBuffer(
+        SoapySDR::Stream *stream,
+        size_t &handle,
+        const void **buffs,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs = 100000);
+
+    void releaseReadBuffer(
+        SoapySDR::Stream *stream,
+        const size_t handle);
+
+    int acquireWriteBuffer(
+        SoapySDR::Stream *stream,
+        size_t &handle,
+        void **buffs,
+        const long timeoutUs = 100000);
+
+    void releaseWriteBuffer(
+        SoapySDR::Stream *stream,
+        const size_t handle,
+        const size_t numElems,
+        int &flags,
+        const long long timeNs = 0);
+
     /*******************************************************************
      * Antenna API
      ******************************************************************/
@@ -279,6 +529,12 @@ public:
 
     std::string readSetting(const std::string &key) const;
 
+    SoapySDR::ArgInfoList getSettingInfo(const int direction, const size_t channel) const;
+
+    void writeSetting(const int direction, const size_t channel, const std::string &key, const std::string &value);
+
+    std::string readSetting(const int direction, const size_t channel, const std::string &key) const;
+
     /*******************************************************************
      * GPIO API
      ******************************************************************/
@@ -332,72 +588,226 @@ private:
 
     long long _rxTicksToTimeNs(const long long ticks) const
     {
-        return SoapySDR::ticksToTimeNs(ticks, _rxSampRate) + _timeNsOffset;
+        return _rxTimeline.ticksToNs(ticks) + _timeNsOffset;
     }
 
     long long _timeNsToRxTicks(const long long timeNs) const
     {
-        return SoapySDR::timeNsToTicks(timeNs-_timeNsOffset, _rxSampRate);
+        return _rxTimeline.nsToTicks(timeNs-_timeNsOffset);
     }
 
     long long _txTicksToTimeNs(const long long ticks) const
     {
-        return SoapySDR::ticksToTimeNs(ticks, _txSampRate) + _timeNsOffset;
+        return _txTimeline.ticksToNs(ticks) + _timeNsOffset;
     }
 
     long long _timeNsToTxTicks(const long long timeNs) const
     {
-        return SoapySDR::timeNsToTicks(timeNs-_timeNsOffset, _txSampRate);
+        return _txTimeline.nsToTicks(timeNs-_timeNsOffset);
+    }
+
+    //! continue the timeline of a direction at a new rate from the tick count startTicks
+    void setTickRate(const int direction, const bladerf_rational_rate &rate, const long long startTicks);
+
+    //! bytes per complex sample of one channel in the wire format
+    static size_t _wireSampleSize(const bladerf_format format)
+    {
+        switch (format)
+        {
+        case BLADERF_FORMAT_SC8_Q7:
+        case BLADERF_FORMAT_SC8_Q7_META: return 2;
+        case BLADERF_FORMAT_SC16_Q11_PACKED: return 3;
+        default: return 4;
+        }
+    }
+
+    //! true when the async stream buffers can be handed to the caller in place
+    bool directAccessCompatible(const int direction) const;
+
+    //! receive at most one buffer of samples with bladerf_sync_rx
+    int readStreamSync(void * const *buffs, size_t numElems, int &flags, long long &timeNs, const long timeoutUs);
+
+    //! receive any number of samples as consecutive sync buffers
+    int readStreamBatch(void * const *buffs, const size_t numElems, int &flags, long long &timeNs, const long timeoutUs);
+
+    //! send at most one buffer of samples with bladerf_sync_tx
+    int writeStreamSync(const void * const *buffs, size_t numElems, int &flags, const long long timeNs, const long timeoutUs);
+
+    //! send any number of samples as consecutive sync buffers
+    int writeStreamBatch(const void * const *buffs, const size_t numElems, int &flags, const long long timeNs, const long timeoutUs);
+
+    int readStreamAsync(void * const *buffs, size_t numElems, int &flags, long long &timeNs, const long timeoutUs);
+
+    int writeStreamAsync(const void * const *buffs, size_t numElems, int &flags, const long long timeNs, const long timeoutUs);
+
+    int readStreamRing(void * const *buffs, size_t numElems, int &flags, long long &timeNs, const long timeoutUs);
+
+    //! rx streaming thread, drains the device into the ring until stopped or the burst completes
+    void rxThreadLoop(StreamMetadata cmd);
+
+    void stopRxThread(void);
+
+    //! count the samples lost ahead of a received buffer that starts at ticks
+    void accountRxTicks(const long long ticks, const size_t numElems, const bool continuous);
+
+    //! return the samples held in the conversion buffer behind a gap fill
+    int readStreamPending(void * const *buffs, size_t numElems, int &flags, long long &timeNs);
+
+    //! synthesize the samples missing ahead of ticks, returns 0 when there is no gap to fill
+    size_t fillRxGap(void * const *buffs, const size_t numElems, const long long ticks, long long &timeNs);
+
+    //! record the end of the samples returned to the caller for the next gap fill
+    void trackRxFill(void * const *buffs, const size_t numElems, const long long nextTicks);
+
+    //! record how far behind the device time the samples starting at timeNs reach the caller
+    void recordRxLatency(const long long timeNs);
+
+    //! queue an rx status event for readStreamStatus, the oldest events are dropped when full
+    void pushRxEvent(const int code, const int flags, const long long ticks, const size_t numElems = 0);
+
+    //! queue a tx status response and wake readStreamStatus
+    void pushTxResponse(const StreamMetadata &resp);
+
+    //! send wire samples with the burst metadata, returns the number sent or an error
+    int sendTxSamples(const void *samples, const size_t numElems, const int flags, const long long ticks, const long timeoutMs);
+
+    int writeStreamRing(const void * const *buffs, size_t numElems, int &flags, const long long timeNs, const long timeoutUs);
+
+    //! tx streaming thread, sends the blocks queued in the ring until stopped
+    void txThreadLoop(void);
+
+    void stopTxThread(void);
+
+    //! probe the capabilities and replace the snapshot
+    void snapshotCapabilities(void);
+
+    //! test if the rx gain mode can be switched to automatic, restores the mode
+    bool probeGainMode(const int direction, const size_t channel) const;
+
+    //! the snapshot of a channel, or nullptr when it has none
+    const ChannelCapabilities *channelCapabilities(const std::shared_ptr<const DeviceCapabilities> &caps, const int direction, const size_t channel) const
+    {
+        const auto &chans = (direction == SOAPY_SDR_RX)?caps->rx:caps->tx;
+        if (channel >= chans.size()) return nullptr;
+        return &chans[channel];
+    }
+
+    std::shared_ptr<const DeviceCapabilities> capabilities(void) const
+    {
+        return std::atomic_load(&_caps);
+    }
+
+    StreamContext &streamContext(const int direction)
+    {
+        if (direction == SOAPY_SDR_RX) return _rx;
+        return _tx;
     }
 
     void updateRxMinTimeoutMs(void)
     {
         //the 2x factor allows padding so we aren't on the fence
-        _rxMinTimeoutMs = long((2*1000*_rxBuffSize)/_rxSampRate);
+        _rx.minTimeoutMs = long((2*1000*_rx.buffSize)/_rxSampRate);
     }
 
     bool _isBladeRF1;
     bool _isBladeRF2;
     double _rxSampRate;
     double _txSampRate;
-    bool _inTxBurst;
-    bool _rxFloats;
-    bool _txFloats;
-    bool _rxOverflow;
-    long long _rxNextTicks;
-    long long _txNextTicks;
+    bladeRF_Timeline _rxTimeline;
+    bladeRF_Timeline _txTimeline;
+    bool _keepTimeline;
     long long _timeNsOffset;
-    int16_t *_rxConvBuff;
-    int16_t *_txConvBuff;
-    size_t _rxBuffSize;
-    size_t _txBuffSize;
-    std::vector<size_t> _rxChans;
-    std::vector<size_t> _txChans;
-    long _rxMinTimeoutMs;
-    std::queue<StreamMetadata> _rxCmds;
-    std::queue<StreamMetadata> _txResps;
+    mutable bladeRF_TimeModel _timeModel;
+    mutable bladeRF_ShadowCache _shadow;
+    std::shared_ptr<const DeviceCapabilities> _caps;
+    RxStreamContext _rx;
+    TxStreamContext _tx;
     std::string _xb200Mode;
     std::string _samplingMode;
     std::string _loopbackMode;
-    bladerf_format _sample_format;
 
     bladerf *_dev;
 
     /*!
      * Will contain a list containing the info on the already computed quick tunes.
-     * The key is (direction, channel, frequency), as defined in setFrequency(direction, channel, name, frequency, args).
+     * The key is (direction, channel, frequency in Hz), the frequency as rounded by setFrequency.
      * The value is the computed bladerf_quick_tune.
      * It is filled when calling setFrequency(direction, channel, name, frequency, args)
-     * with "saveQuickTune" in the args.
+     * with "saveQuickTune" in the args, and by the hop plans.
+     * The profiles live in the FPGA, so the list is dropped when the FPGA is loaded.
      */
-    std::map<std::tuple<int, size_t, double>, bladerf_quick_tune*> _quickTunesByDirChanAndFreq;
+    std::map<std::tuple<int, size_t, bladerf_frequency>, bladerf_quick_tune> _quickTunes;
+    //! The quick tune profiles used per direction since the FPGA was loaded.
+    std::map<int, size_t> _quickTuneProfiles;
     //! Gets the quick tune info at the current frequency. Only available on BladeRF2.
-    bladerf_quick_tune* getQuickTune(const int direction, const size_t channel) const;
+    bool getQuickTune(const int direction, const size_t channel, bladerf_quick_tune &quickTune);
     /*!
      * Retunes to a specific quick tune.Only available on BladeRF2.
      * This is usually not blocking (bladerf_schedule_retune is usually not blocking, unlike bladerf_set_frequency).
      */
-    void retune(const int direction, const size_t channel, long long timestamp, bladerf_quick_tune* conf);
+    void retune(const int direction, const size_t channel, long long timestamp, bladerf_quick_tune &conf);
+    //! Notes a retune that lands at timeNs, the frequency and gains of the direction are read from the device until then.
+    void holdRetune(const int direction, const long long timeNs);
+    //! True while a scheduled retune of the direction may not have landed. Drops the stale cached values once it has.
+    bool retunePending(const int direction) const;
+    //! The time in ns after which the scheduled retunes of each direction have landed.
+    mutable std::atomic<long long> _rxRetuneUntilNs;
+    mutable std::atomic<long long> _txRetuneUntilNs;
+    //! Tunes and stores the quick tune of a frequency, unless it is already stored. Throws when out of profiles.
+    const bladerf_quick_tune &calibrateQuickTune(const int direction, const size_t channel, const bladerf_frequency frequency);
+    //! Forgets the quick tunes and hop plans after the FPGA profiles were lost.
+    void clearQuickTunes(void);
+
+    //! The hop plan frequencies in Hz by (direction, channel).
+    std::map<std::pair<int, size_t>, std::vector<bladerf_frequency>> _hopPlans;
+    //! Calibrates the comma separated frequencies of a hop plan.
+    void setHopPlan(const int direction, const size_t channel, const std::string &value);
+    //! Starts hopping through the plan with start, dwell and count args, or cancels with no args.
+    void setHopSchedule(const int direction, const size_t channel, const std::string &value);
+    //! The progress of the hop schedule as key=value pairs.
+    std::string getHopSchedule(const int direction, const size_t channel) const;
+    //! Hop thread, keeps the FPGA retune queue filled with the scheduled hops.
+    void hopThreadLoop(void);
+    void stopHopThread(void);
+
+    std::map<std::pair<int, size_t>, HopSchedule> _hopSchedules;
+    bool _hopRunning;
+    std::thread _hopThread;
+    mutable std::mutex _hopMutex;
+    std::condition_variable _hopCond;
     //! Sets the RF frequency. Throws a runtime_error if bladerf_set_frequency is unsuccessful.
     void setRfFrequency(const int direction, const size_t channel, const double frequency);
+    //! Sets the overall gain, or the named gain stage. Throws a runtime_error on failure.
+    void setRfGain(const int direction, const size_t channel, const std::string &name, const double value);
+    //! Sets the filter bandwidth, bypassing the filter above its range. Throws a runtime_error on failure.
+    void setRfBandwidth(const int direction, const size_t channel, const double bw);
+
+    //! queue a change for the control thread, false when async control is disabled
+    bool queueControl(const ControlParam param, const int direction, const size_t channel, const std::string &name, const double value);
+
+    //! apply one queued change on the control thread
+    void applyControl(const ControlParam param, const int direction, const size_t channel, const std::string &name, const double value);
+
+    //! wait until the control thread applied the changes queued for a channel, before a synchronous setter touches it
+    void drainControl(const int direction, const size_t channel);
+
+    //! control thread, applies the latest queued changes until stopped
+    void controlThreadLoop(void);
+
+    void startControlThread(void);
+
+    //! stop the control thread after it has applied the pending changes
+    void stopControlThread(void);
+
+    bool _asyncControl;
+    std::thread _controlThread;
+    mutable std::mutex _controlMutex;
+    std::condition_variable _controlCond;
+    ControlChanges _controlChanges;
+    //! the batch the control thread is applying, read under the lock
+    ControlChanges _controlApplying;
+    unsigned long long _controlQueued;
+    unsigned long long _controlApplied;
+    unsigned long long _controlErrors;
+    std::string _controlLastError;
 };
@@ -20,6 +20,9 @@
  */
 
 #include "bladeRF_SoapySDR.hpp"
+#include "bladeRF_Conversions.hpp"
+#include "bladeRF_AsyncStream.hpp"
+#include "bladeRF_RingBuffer.hpp"
 #include <SoapySDR/Formats.hpp>
 #include <SoapySDR/Logger.hpp>
 #include <stdexcept>
@@ -30,10 +33,25 @@
 
 #define DEF_NUM_BUFFS 32
 #define DEF_BUFF_LEN 4096
+#define DEF_RING_LEN (1 << 20)
+#define DEF_GAP_MAX (1 << 20)
+#define MAX_STATUS_EVENTS 1024
+#define TX_DRAIN_TIMEOUT_US 1000000 //1 s
+
+static ConvertWireFormat toConvertWire(const bladerf_format format)
+{
+    switch (format)
+    {
+    case BLADERF_FORMAT_SC8_Q7:
+    case BLADERF_FORMAT_SC8_Q7_META: return CONVERT_WIRE_SC8;
+    case BLADERF_FORMAT_SC16_Q11_PACKED: return CONVERT_WIRE_SC12;
+    default: return CONVERT_WIRE_SC16;
+    }
+}
 
 std::vector<std::string> bladeRF_SoapySDR::getStreamFormats(const int, const size_t) const
 {
-    return {SOAPY_SDR_CS16, SOAPY_SDR_CF32};
+    return {SOAPY_SDR_CS8, SOAPY_SDR_CS12, SOAPY_SDR_CS16, SOAPY_SDR_CF32};
 }
 
 std::string bladeRF_SoapySDR::getNativeStreamFormat(const int, const size_t, double &fullScale) const
@@ -78,12 +96,68 @@ SoapySDR::ArgInfoList bladeRF_SoapySDR::getStreamArgsInfo(const int, const size_
     formatArg.key = "format";
     formatArg.value = "sc16_meta";
     formatArg.name = "Sample Format";
-    formatArg.description = "Sample format (sc16, sc16_meta, sc8, sc8_meta, sc16_packed)";
+    formatArg.description = "Sample format (sc16, sc16_meta, sc8, sc8_meta, sc16_packed). CS8 streams default to sc8_meta, CS12 streams require sc16_packed.";
     formatArg.type = SoapySDR::ArgInfo::STRING;
     formatArg.options = {"sc16", "sc16_meta", "sc8", "sc8_meta", "sc16_packed"};
     formatArg.optionNames = {"16-bit", "16-bit with Metadata", "8-bit", "8-bit with Metadata", "Packed 16-bit"};
     streamArgs.push_back(formatArg);
 
+    SoapySDR::ArgInfo directArg;
+    directArg.key = "direct";
+    directArg.value = "false";
+    directArg.name = "Direct Buffer Access";
+    directArg.description = "Stream with the libbladeRF async interface so the USB buffers can be accessed in place. "
+        "Requires a format without metadata, timestamps are not available.";
+    directArg.type = SoapySDR::ArgInfo::BOOL;
+    streamArgs.push_back(directArg);
+
+    SoapySDR::ArgInfo threadedArg;
+    threadedArg.key = "threaded";
+    threadedArg.value = "false";
+    threadedArg.name = "Streaming Thread";
+    threadedArg.description = "Stream in a background thread that queues samples in a ring buffer. "
+        "Reads and writes do not block on the device, so pauses in the application are absorbed by the ring.";
+    threadedArg.type = SoapySDR::ArgInfo::BOOL;
+    streamArgs.push_back(threadedArg);
+
+    SoapySDR::ArgInfo batchArg;
+    batchArg.key = "batch";
+    batchArg.value = "false";
+    batchArg.name = "Batch Transfers";
+    batchArg.description = "Let a single read or write transfer more than one buffer of samples. "
+        "The call loops over the sync interface instead of clipping to the stream MTU.";
+    batchArg.type = SoapySDR::ArgInfo::BOOL;
+    streamArgs.push_back(batchArg);
+
+    SoapySDR::ArgInfo ringLengthArg;
+    ringLengthArg.key = "ringlen";
+    ringLengthArg.value = std::to_string(DEF_RING_LEN);
+    ringLengthArg.name = "Ring Length";
+    ringLengthArg.description = "Number of samples per channel queued by the streaming thread, rounded up to whole buffers.";
+    ringLengthArg.units = "samples";
+    ringLengthArg.type = SoapySDR::ArgInfo::INT;
+    streamArgs.push_back(ringLengthArg);
+
+    SoapySDR::ArgInfo gapFillArg;
+    gapFillArg.key = "gapfill";
+    gapFillArg.value = "none";
+    gapFillArg.name = "Gap Filling";
+    gapFillArg.description = "Synthesize the samples lost to an overflow so the sample count follows the hardware time (RX only). "
+        "The overflow is still reported, the missing samples are then returned as zeros or as the last sample held.";
+    gapFillArg.type = SoapySDR::ArgInfo::STRING;
+    gapFillArg.options = {"none", "zeros", "hold"};
+    gapFillArg.optionNames = {"None", "Zeros", "Hold Last Sample"};
+    streamArgs.push_back(gapFillArg);
+
+    SoapySDR::ArgInfo gapMaxArg;
+    gapMaxArg.key = "gapmax";
+    gapMaxArg.value = std::to_string(DEF_GAP_MAX);
+    gapMaxArg.name = "Gap Fill Limit";
+    gapMaxArg.description = "The longest gap that is filled, longer gaps are left as a discontinuity in the stream.";
+    gapMaxArg.units = "samples";
+    gapMaxArg.type = SoapySDR::ArgInfo::INT;
+    streamArgs.push_back(gapMaxArg);
+
     return streamArgs;
 }
 
@@ -96,18 +170,29 @@ SoapySDR::Stream *bladeRF_SoapySDR::setupStream(
     auto channels = channels_;
     if (channels.empty()) channels.push_back(0);
 
-    auto sampleFormat = (args.count("format") == 0)? "sc16_meta" : args.at("format");
+    //direct buffer access uses the async interface, which does not support metadata
+    const bool direct = (args.count("direct") != 0 and args.at("direct") == "true");
+    const bool threaded = (args.count("threaded") != 0 and args.at("threaded") == "true");
+    const bool batch = (args.count("batch") != 0 and args.at("batch") == "true");
+    if (direct and threaded) throw std::runtime_error("setupStream direct and threaded streaming are exclusive");
 
+    //the 8-bit and 12-bit host formats default to the matching wire format so samples are not converted
+    std::string defaultFormat = (format == SOAPY_SDR_CS8)? "sc8" : "sc16";
+    if (not direct) defaultFormat += "_meta";
+    if (format == SOAPY_SDR_CS12) defaultFormat = "sc16_packed";
+    auto sampleFormat = (args.count("format") == 0)? defaultFormat : args.at("format");
+
+    bladerf_format wireFormat;
     if (sampleFormat == "sc16") {
-        _sample_format = BLADERF_FORMAT_SC16_Q11;
+        wireFormat = BLADERF_FORMAT_SC16_Q11;
     } else if (sampleFormat == "sc16_meta") {
-        _sample_format = BLADERF_FORMAT_SC16_Q11_META;
+        wireFormat = BLADERF_FORMAT_SC16_Q11_META;
     } else if (sampleFormat == "sc8") {
-        _sample_format = BLADERF_FORMAT_SC8_Q7;
+        wireFormat = BLADERF_FORMAT_SC8_Q7;
     } else if (sampleFormat == "sc8_meta") {
-        _sample_format = BLADERF_FORMAT_SC8_Q7_META;
+        wireFormat = BLADERF_FORMAT_SC8_Q7_META;
     } else if (sampleFormat == "sc16_packed") {
-        _sample_format = BLADERF_FORMAT_SC16_Q11_PACKED;
+        wireFormat = BLADERF_FORMAT_SC16_Q11_PACKED;
     } else {
         std::stringstream err;
         err << "Invalid sample format: '" << sampleFormat << "'\n"
@@ -115,6 +200,21 @@ SoapySDR::Stream *bladeRF_SoapySDR::setupStream(
         throw std::runtime_error(err.str());
     }
 
+    if (direct and (wireFormat == BLADERF_FORMAT_SC16_Q11_META or wireFormat == BLADERF_FORMAT_SC8_Q7_META))
+    {
+        throw std::runtime_error("setupStream direct buffer access requires a format without metadata, got " + sampleFormat);
+    }
+
+    //gaps are found from the timestamps, which the async interface does not provide
+    const std::string gapFill = (args.count("gapfill") == 0)? "none" : args.at("gapfill");
+    GapFillMode gapFillMode = GAP_FILL_NONE;
+    if (gapFill == "zeros") gapFillMode = GAP_FILL_ZEROS;
+    else if (gapFill == "hold") gapFillMode = GAP_FILL_HOLD;
+    else if (gapFill != "none") throw std::runtime_error("setupStream invalid gap filling: " + gapFill);
+    if (direct and gapFillMode != GAP_FILL_NONE) throw std::runtime_error("setupStream gap filling requires timestamps, not available with direct buffer access");
+    long long gapMax = (args.count("gapmax") == 0)? 0 : atoll(args.at("gapmax").c_str());
+    if (gapMax <= 0) gapMax = DEF_GAP_MAX;
+
     //check the channel configuration
     bladerf_channel_layout layout;
     if (channels.size() == 1 and (channels.at(0) == 0 or channels.at(0) == 1))
@@ -130,12 +230,13 @@ SoapySDR::Stream *bladeRF_SoapySDR::setupStream(
         throw std::runtime_error("setupStream invalid channel selection");
     }
 
-    SoapySDR::logf(SOAPY_SDR_INFO, "Sample format: %s", bladerf_format_to_string(_sample_format));
+    SoapySDR::logf(SOAPY_SDR_INFO, "Sample format: %s", bladerf_format_to_string(wireFormat));
+    SoapySDR::logf(SOAPY_SDR_DEBUG, "Sample conversion kernels: %s", getConvertKernels().isa);
 
-    //check the format
-    if (format == SOAPY_SDR_CF32) {}
-    else if (format == SOAPY_SDR_CS16) {}
-    else throw std::runtime_error("setupStream invalid format " + format);
+    //check the format and resolve the sample converter for this stream
+    const StreamConverter *converter = findStreamConverter(
+        direction == SOAPY_SDR_TX, toConvertWire(wireFormat), format, channels.size());
+    if (converter == nullptr) throw std::runtime_error("setupStream invalid format " + format + " for " + sampleFormat);
 
     //determine the number of buffers to allocate
     int numBuffs = (args.count("buffers") == 0)? 0 : atoi(args.at("buffers").c_str());
@@ -153,19 +254,39 @@ SoapySDR::Stream *bladeRF_SoapySDR::setupStream(
     if (numXfers > numBuffs) numXfers = numBuffs; //cant have more than available buffers
     if (numXfers > 32) numXfers = 32; //libusb limit
 
+    //a stream set up again without closeStream replaces the old one,
+    //stop everything that still uses its buffers before they are freed
+    StreamContext &ctx = this->streamContext(direction);
+    if (direction == SOAPY_SDR_RX) this->stopRxThread();
+    if (direction == SOAPY_SDR_TX) this->stopTxThread();
+    delete ctx.async;
+    ctx.async = nullptr;
+    delete ctx.ring;
+    ctx.ring = nullptr;
+
+    //setup the async stream for direct buffer access
+    int ret = 0;
+    if (direct)
+    {
+        ctx.async = new bladeRF_AsyncStream(_dev, layout, wireFormat, numBuffs, bufSize, numXfers);
+    }
+
     //setup the stream for sync tx/rx calls
-    int ret = bladerf_sync_config(
-        _dev,
-        layout,
-        _sample_format,
-        numBuffs,
-        bufSize,
-        numXfers,
-        1000); //1 second timeout
-    if (ret != 0)
+    else
     {
-        SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_sync_config() returned %d", ret);
-        throw std::runtime_error("setupStream() " + _err2str(ret));
+        ret = bladerf_sync_config(
+            _dev,
+            layout,
+            wireFormat,
+            numBuffs,
+            bufSize,
+            numXfers,
+            1000); //1 second timeout
+        if (ret != 0)
+        {
+            SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_sync_config() returned %d", ret);
+            throw std::runtime_error("setupStream() " + _err2str(ret));
+        }
     }
 
     //enable channels used in streaming
@@ -179,63 +300,92 @@ SoapySDR::Stream *bladeRF_SoapySDR::setupStream(
         }
     }
 
+    //size the ring for the streaming thread in whole buffers
+    long ringLen = (args.count("ringlen") == 0)? 0 : atol(args.at("ringlen").c_str());
+    if (ringLen <= 0) ringLen = DEF_RING_LEN;
+    const size_t numBlocks = std::max<long>(2, (ringLen + bufSize - 1) / bufSize);
+    StreamBlock block;
+    if (threaded)
+    {
+        block.samples.resize(bufSize*2*channels.size());
+        SoapySDR::logf(SOAPY_SDR_INFO, "Streaming thread ring: %d samples", int(numBlocks*bufSize));
+    }
+
+    ctx.format = wireFormat;
+    ctx.converter = converter;
+    ctx.chans = channels;
+    ctx.batch = batch;
+    ctx.hostSampleSize = SoapySDR::formatToSize(format);
+    ctx.convBuff.assign(bufSize*2*channels.size(), 0);
+    ctx.buffSize = bufSize;
+
+    if (threaded) ctx.ring = new bladeRF_RingBuffer<StreamBlock>(numBlocks, block);
+
     if (direction == SOAPY_SDR_RX)
     {
-        _rxOverflow = false;
-        _rxChans = channels;
-        _rxFloats = (format == SOAPY_SDR_CF32);
-        _rxConvBuff = new int16_t[bufSize*2*_rxChans.size()];
-        _rxBuffSize = bufSize;
+        _rx.overflow = false;
+        _rx.expectTicks = -1;
+        _rx.droppedSamples = 0;
+        _rx.latency.reset();
+        {
+            std::lock_guard<std::mutex> lock(_rx.eventMutex);
+            _rx.events = std::queue<StreamMetadata>();
+        }
+        _rx.gapFill = gapFillMode;
+        _rx.gapMax = gapMax;
+        _rx.fillTicks = -1;
+        _rx.holdSample.assign(_rx.hostSampleSize*_rx.chans.size(), 0);
+        _rx.pendingElems = 0;
+        _rx.asyncRemaining = 0;
+        _rx.ringOffset = 0;
         this->updateRxMinTimeoutMs();
     }
 
     if (direction == SOAPY_SDR_TX)
     {
-        _txFloats = (format == SOAPY_SDR_CF32);
-        _txChans = channels;
-        _txConvBuff = new int16_t[bufSize*2*_txChans.size()];
-        _txBuffSize = bufSize;
-        _inTxBurst = false;
+        _tx.asyncAcquired = false;
+        _tx.inBurst = false;
+        _tx.ringFill = 0;
     }
 
-    return (SoapySDR::Stream *)(new int(direction));
+    return reinterpret_cast<SoapySDR::Stream *>(&ctx);
 }
 
 void bladeRF_SoapySDR::closeStream(SoapySDR::Stream *stream)
 {
-    const int direction = *reinterpret_cast<int *>(stream);
-    auto &chans = (direction == SOAPY_SDR_RX)?_rxChans:_txChans;
+    StreamContext &ctx = *reinterpret_cast<StreamContext *>(stream);
+    const int direction = ctx.direction;
+
+    //stop everything that moves samples before the modules go down
+    if (direction == SOAPY_SDR_RX) this->stopRxThread();
+    if (direction == SOAPY_SDR_TX) this->stopTxThread();
+    delete ctx.async;
+    ctx.async = nullptr;
+    delete ctx.ring;
+    ctx.ring = nullptr;
 
     //deactivate the stream here -- only call once
-    for (const auto ch : chans)
+    //every channel is disabled even after a failure, the first error is reported
+    int err = 0;
+    for (const auto ch : ctx.chans)
     {
         const int ret = bladerf_enable_module(_dev, _toch(direction, ch), false);
         if (ret != 0)
         {
             SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_enable_module(false) returned %s", _err2str(ret).c_str());
-            throw std::runtime_error("closeStream() " + _err2str(ret));
+            if (err == 0) err = ret;
         }
     }
-    chans.clear();
+    ctx.chans.clear();
 
     //cleanup stream convert buffers
-    if (direction == SOAPY_SDR_RX)
-    {
-        delete [] _rxConvBuff;
-    }
-
-    if (direction == SOAPY_SDR_TX)
-    {
-        delete [] _txConvBuff;
-    }
-
-    delete reinterpret_cast<int *>(stream);
+    std::vector<int16_t>().swap(ctx.convBuff);
+    if (err != 0) throw std::runtime_error("closeStream() " + _err2str(err));
 }
 
 size_t bladeRF_SoapySDR::getStreamMTU(SoapySDR::Stream *stream) const
 {
-    const int direction = *reinterpret_cast<int *>(stream);
-    return (direction == SOAPY_SDR_RX)?_rxBuffSize:_txBuffSize;
+    return reinterpret_cast<const StreamContext *>(stream)->buffSize;
 }
 
 int bladeRF_SoapySDR::activateStream(
@@ -244,20 +394,56 @@ int bladeRF_SoapySDR::activateStream(
     const long long timeNs,
     const size_t numElems)
 {
-    const int direction = *reinterpret_cast<int *>(stream);
+    const int direction = reinterpret_cast<StreamContext *>(stream)->direction;
+
+    //async streams run continuously without timed or finite bursts
+    auto async = (direction == SOAPY_SDR_RX)?_rx.async:_tx.async;
+    if (async != nullptr)
+    {
+        if (flags != 0 or numElems != 0) return SOAPY_SDR_NOT_SUPPORTED;
+        async->start();
+        return 0;
+    }
 
     if (direction == SOAPY_SDR_RX)
     {
+        //the latency is measured against the time model, make sure that it is running
+        if (not _timeModel.fresh(bladeRF_TimeModel::Clock::now(), std::chrono::seconds(1))) this->getHardwareTime();
+
         StreamMetadata cmd;
         cmd.flags = flags;
         cmd.timeNs = timeNs;
         cmd.numElems = numElems;
-        _rxCmds.push(cmd);
+
+        //the streaming thread carries out the command, a new command restarts it
+        if (_rx.ring != nullptr)
+        {
+            this->stopRxThread();
+            _rx.ring->clear();
+            _rx.ringOffset = 0;
+            _rx.expectTicks = -1;
+            _rx.fillTicks = -1;
+            _rx.threadRunning = true;
+            _rx.thread = std::thread(&bladeRF_SoapySDR::rxThreadLoop, this, cmd);
+            return 0;
+        }
+
+        //the time between activations is not a gap in the stream
+        _rx.expectTicks = -1;
+        _rx.fillTicks = -1;
+        _rx.cmds.push(cmd);
     }
 
     if (direction == SOAPY_SDR_TX)
     {
         if (flags != 0) return SOAPY_SDR_NOT_SUPPORTED;
+
+        //start the streaming thread once, it idles while the ring is empty
+        if (_tx.ring != nullptr and not _tx.thread.joinable())
+        {
+            _tx.threadRunning = true;
+            _tx.thread = std::thread(&bladeRF_SoapySDR::txThreadLoop, this);
+        }
     }
 
     return 0;
@@ -268,19 +454,66 @@ int bladeRF_SoapySDR::deactivateStream(
     const int flags,
     const long long)
 {
-    const int direction = *reinterpret_cast<int *>(stream);
+    const int direction = reinterpret_cast<StreamContext *>(stream)->direction;
     if (flags != 0) return SOAPY_SDR_NOT_SUPPORTED;
 
+    //stopping the async stream reclaims all buffers, including partially used ones
+    auto async = (direction == SOAPY_SDR_RX)?_rx.async:_tx.async;
+    if (async != nullptr)
+    {
+        async->stop();
+        if (direction == SOAPY_SDR_RX) _rx.asyncRemaining = 0;
+        if (direction == SOAPY_SDR_TX) _tx.asyncAcquired = false;
+        return 0;
+    }
+
     if (direction == SOAPY_SDR_RX)
     {
-        //clear all commands when deactivating
-        while (not _rxCmds.empty()) _rxCmds.pop();
+        //clear all commands and held samples when deactivating
+        while (not _rx.cmds.empty()) _rx.cmds.pop();
+        _rx.pendingElems = 0;
+
+        //stop the streaming thread and drop the queued samples
+        if (_rx.ring != nullptr)
+        {
+            this->stopRxThread();
+            _rx.ring->clear();
+            _rx.ringOffset = 0;
+        }
     }
 
     if (direction == SOAPY_SDR_TX)
     {
+        if (_tx.ring != nullptr)
+        {
+            //hand the partly filled block to the streaming thread,
+            //then let it send everything writeStream accepted, including the end of burst
+            if (_tx.ringFill != 0 and _tx.ring->waitBack(TX_DRAIN_TIMEOUT_US))
+            {
+                StreamBlock *block = _tx.ring->back();
+                block->numElems = _tx.ringFill;
+                _tx.ringFill = 0;
+                _tx.ring->push();
+            }
+            if (_tx.threadRunning) _tx.ring->waitEmpty(TX_DRAIN_TIMEOUT_US);
+            this->stopTxThread();
+
+            //only what the device did not take in time is dropped
+            const size_t dropped = _tx.ring->size() + ((_tx.ringFill != 0)?1:0);
+            if (dropped != 0)
+            {
+                SoapySDR::logf(SOAPY_SDR_WARNING, "deactivateStream() dropped %d queued TX blocks", int(dropped));
+                StreamMetadata resp;
+                resp.flags = 0;
+                resp.code = SOAPY_SDR_TIMEOUT;
+                this->pushTxResponse(resp);
+            }
+            _tx.ring->clear();
+            _tx.ringFill = 0;
+        }
+
         //in a burst -> end it
-        if (_inTxBurst)
+        if (_tx.inBurst)
         {
             //initialize metadata
             bladerf_metadata md;
@@ -289,11 +522,11 @@ int bladeRF_SoapySDR::deactivateStream(
             md.status = 0;
 
             //send the tx samples
-            _txConvBuff[0] = 0;
-            _txConvBuff[1] = 0;
-            bladerf_sync_tx(_dev, _txConvBuff, 1, &md, 100/*ms*/);
+            _tx.convBuff[0] = 0;
+            _tx.convBuff[1] = 0;
+            bladerf_sync_tx(_dev, _tx.convBuff.data(), 1, &md, 100/*ms*/);
         }
-        _inTxBurst = false;
+        _tx.inBurst = false;
     }
 
     return 0;
@@ -306,25 +539,41 @@ int bladeRF_SoapySDR::readStream(
     int &flags,
     long long &timeNs,
     const long timeoutUs)
+{
+    if (_rx.async != nullptr) return this->readStreamAsync(buffs, numElems, flags, timeNs, timeoutUs);
+    if (_rx.ring != nullptr) return this->readStreamRing(buffs, numElems, flags, timeNs, timeoutUs);
+    if (_rx.batch) return this->readStreamBatch(buffs, numElems, flags, timeNs, timeoutUs);
+    return this->readStreamSync(buffs, numElems, flags, timeNs, timeoutUs);
+}
+
+int bladeRF_SoapySDR::readStreamSync(
+    void * const *buffs,
+    size_t numElems,
+    int &flags,
+    long long &timeNs,
+    const long timeoutUs)
 {
     //clip to the available conversion buffer size
-    numElems = std::min(numElems, _rxBuffSize);
+    numElems = std::min(numElems, _rx.buffSize);
+
+    //samples held back behind a gap fill are returned before receiving more
+    if (_rx.pendingElems != 0) return this->readStreamPending(buffs, numElems, flags, timeNs);
 
     //extract the front-most command
     //no command, this is a timeout...
-    if (_rxCmds.empty()) return SOAPY_SDR_TIMEOUT;
-    StreamMetadata &cmd = _rxCmds.front();
+    if (_rx.cmds.empty()) return SOAPY_SDR_TIMEOUT;
+    StreamMetadata &cmd = _rx.cmds.front();
 
     //clear output metadata
     flags = 0;
     timeNs = 0;
 
     //return overflow status indicator
-    if (_rxOverflow)
+    if (_rx.overflow)
     {
-        _rxOverflow = false;
+        _rx.overflow = false;
         flags |= SOAPY_SDR_HAS_TIME;
-        timeNs = _rxTicksToTimeNs(_rxNextTicks);
+        timeNs = _rxTicksToTimeNs(_rx.nextTicks);
         return SOAPY_SDR_OVERFLOW;
     }
 
@@ -338,75 +587,34 @@ int bladeRF_SoapySDR::readStream(
     if (cmd.numElems > 0) numElems = std::min(cmd.numElems, numElems);
     cmd.flags = 0; //clear flags for subsequent calls
 
-    //prepare buffers
+    //prepare buffers, receive directly into the output when the host format matches the wire,
+    //gap filling keeps the samples in the conversion buffer until the gap ahead of them is filled
     void *samples = (void *)buffs[0];
-    if (_rxFloats or _rxChans.size() == 2) samples = _rxConvBuff;
+    if (not _rx.converter->passthrough or _rx.gapFill != GAP_FILL_NONE) samples = _rx.convBuff.data();
+    const bool continuous = (md.flags & BLADERF_META_FLAG_RX_NOW) != 0;
 
     //recv the rx samples
-    const long timeoutMs = std::max(_rxMinTimeoutMs, timeoutUs/1000);
-    int ret = bladerf_sync_rx(_dev, samples, numElems*_rxChans.size(), &md, timeoutMs);
+    const long timeoutMs = std::max(_rx.minTimeoutMs, timeoutUs/1000);
+    int ret = bladerf_sync_rx(_dev, samples, numElems*_rx.chans.size(), &md, timeoutMs);
     if (ret == BLADERF_ERR_TIMEOUT) return SOAPY_SDR_TIMEOUT;
-    if (ret == BLADERF_ERR_TIME_PAST) return SOAPY_SDR_TIME_ERROR;
+    if (ret == BLADERF_ERR_TIME_PAST)
+    {
+        this->pushRxEvent(SOAPY_SDR_TIME_ERROR, SOAPY_SDR_HAS_TIME, md.timestamp);
+        return SOAPY_SDR_TIME_ERROR;
+    }
     if (ret != 0)
     {
         //any error when this is a finite burst causes the command to be removed
-        if (cmd.numElems > 0) _rxCmds.pop();
+        if (cmd.numElems > 0) _rx.cmds.pop();
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_sync_rx() returned %s", _err2str(ret).c_str());
+        this->pushRxEvent(SOAPY_SDR_STREAM_ERROR, 0, 0);
         return SOAPY_SDR_STREAM_ERROR;
     }
 
     //actual count is number of samples in total all channels
-    numElems = md.actual_count / _rxChans.size();
-
-    //perform the int16 to float conversion
-    if (_rxFloats and _rxChans.size() == 1)
-    {
-        float *output = (float *)buffs[0];
-        for (size_t i = 0; i < 2 * numElems; i++)
-        {
-            output[i] = float(_rxConvBuff[i])/2048;
-            if (_sample_format == BLADERF_FORMAT_SC8_Q7 || _sample_format == BLADERF_FORMAT_SC8_Q7_META)
-                output[i] = float(((int8_t*)(_rxConvBuff))[i])/128;
-        }
-    }
-    else if (not _rxFloats and _rxChans.size() == 2)
-    {
-        int16_t *output0 = (int16_t *)buffs[0];
-        int16_t *output1 = (int16_t *)buffs[1];
-        for (size_t i = 0; i < 4 * numElems;)
-        {
-            if (_sample_format == BLADERF_FORMAT_SC8_Q7 || _sample_format == BLADERF_FORMAT_SC8_Q7_META) {
-                *(output0++) = ((int8_t*)(_rxConvBuff))[i++];
-                *(output0++) = ((int8_t*)(_rxConvBuff))[i++];
-                *(output1++) = ((int8_t*)(_rxConvBuff))[i++];
-                *(output1++) = ((int8_t*)(_rxConvBuff))[i++];
-            } else {
-                *(output0++) = _rxConvBuff[i++];
-                *(output0++) = _rxConvBuff[i++];
-                *(output1++) = _rxConvBuff[i++];
-                *(output1++) = _rxConvBuff[i++];
-            }
-        }
-    }
-    else if (_rxFloats and _rxChans.size() == 2)
-    {
-        float *output0 = (float *)buffs[0];
-        float *output1 = (float *)buffs[1];
-        for (size_t i = 0; i < 4 * numElems;)
-        {
-            if (_sample_format == BLADERF_FORMAT_SC8_Q7 || _sample_format == BLADERF_FORMAT_SC8_Q7_META) {
-                *(output0++) = float(((int8_t*)(_rxConvBuff))[i++])/128;
-                *(output0++) = float(((int8_t*)(_rxConvBuff))[i++])/128;
-                *(output1++) = float(((int8_t*)(_rxConvBuff))[i++])/128;
-                *(output1++) = float(((int8_t*)(_rxConvBuff))[i++])/128;
-            } else {
-                *(output0++) = float(_rxConvBuff[i++])/2048;
-                *(output0++) = float(_rxConvBuff[i++])/2048;
-                *(output1++) = float(_rxConvBuff[i++])/2048;
-                *(output1++) = float(_rxConvBuff[i++])/2048;
-            }
-        }
-    }
+    numElems = md.actual_count / _rx.chans.size();
+    this->accountRxTicks(md.timestamp, numElems, continuous);
+    _timeModel.bound(bladeRF_TimeModel::Clock::now(), _rxTicksToTimeNs(md.timestamp + numElems));
 
     //unpack the metadata
     flags |= SOAPY_SDR_HAS_TIME;
@@ -416,7 +624,7 @@ int bladeRF_SoapySDR::readStream(
     if ((md.status & BLADERF_META_STATUS_OVERRUN) != 0)
     {
         SoapySDR::log(SOAPY_SDR_SSI, "0");
-        _rxOverflow = true;
+        _rx.overflow = true;
     }
 
     //add flags specific to BladeRF from bladerf_sync_rx.status.
@@ -429,13 +637,130 @@ int bladeRF_SoapySDR::readStream(
     if (cmd.numElems > 0)
     {
         cmd.numElems -= numElems;
-        if (cmd.numElems == 0) _rxCmds.pop();
+        if (cmd.numElems == 0)
+        {
+            _rx.cmds.pop();
+            this->pushRxEvent(0, SOAPY_SDR_END_BURST | SOAPY_SDR_HAS_TIME, md.timestamp + numElems);
+        }
     }
 
-    _rxNextTicks = md.timestamp + numElems;
+    _rx.nextTicks = md.timestamp + numElems;
+
+    //hold the samples, a timed read starts a new timeline without a gap to fill
+    if (_rx.gapFill != GAP_FILL_NONE)
+    {
+        if (not continuous) _rx.fillTicks = -1;
+        _rx.pendingTicks = md.timestamp;
+        _rx.pendingOffset = 0;
+        _rx.pendingElems = numElems;
+        _rx.pendingFlags = flags;
+        return this->readStreamPending(buffs, numElems, flags, timeNs);
+    }
+
+    //perform the conversion from the wire format
+    if (samples != buffs[0]) _rx.converter->toHost(_rx.convBuff.data(), buffs, numElems);
+    this->recordRxLatency(timeNs);
+    return numElems;
+}
+
+int bladeRF_SoapySDR::readStreamPending(
+    void * const *buffs,
+    size_t numElems,
+    int &flags,
+    long long &timeNs)
+{
+    flags = SOAPY_SDR_HAS_TIME;
+    const long long ticks = _rx.pendingTicks + (long long)(_rx.pendingOffset);
+    const size_t filled = this->fillRxGap(buffs, numElems, ticks, timeNs);
+    if (filled != 0) return int(filled);
+
+    //convert out of the conversion buffer, the flags of the read go with its samples
+    numElems = std::min(numElems, _rx.pendingElems - _rx.pendingOffset);
+    const size_t sampleSize = _wireSampleSize(_rx.format) * _rx.chans.size();
+    const char *input = (const char *)_rx.convBuff.data();
+    _rx.converter->toHost(input + _rx.pendingOffset * sampleSize, buffs, numElems);
+    flags |= _rx.pendingFlags;
+    timeNs = _rxTicksToTimeNs(ticks);
+
+    _rx.pendingOffset += numElems;
+    if (_rx.pendingOffset == _rx.pendingElems) _rx.pendingElems = 0;
+    this->trackRxFill(buffs, numElems, ticks + (long long)(numElems));
+    this->recordRxLatency(timeNs);
     return numElems;
 }
 
+size_t bladeRF_SoapySDR::fillRxGap(
+    void * const *buffs,
+    const size_t numElems,
+    const long long ticks,
+    long long &timeNs)
+{
+    //nothing to fill when disabled, on a new timeline, or without missing samples
+    if (_rx.gapFill == GAP_FILL_NONE or _rx.fillTicks < 0 or ticks <= _rx.fillTicks) return 0;
+
+    //a gap over the limit stays a discontinuity rather than stalling the caller on fill
+    const long long gap = ticks - _rx.fillTicks;
+    if (gap > _rx.gapMax)
+    {
+        SoapySDR::logf(SOAPY_SDR_DEBUG, "RX gap of %lld samples not filled", gap);
+        _rx.fillTicks = ticks;
+        return 0;
+    }
+
+    //fill at most one call worth of samples, the rest of the gap continues on the next call
+    const size_t n = size_t(std::min<long long>(gap, (long long)(numElems)));
+    for (size_t i = 0; i < _rx.chans.size(); i++)
+    {
+        if (_rx.gapFill == GAP_FILL_ZEROS) std::memset(buffs[i], 0, n * _rx.hostSampleSize);
+        else fillSamples(buffs[i], _rx.holdSample.data() + i * _rx.hostSampleSize, _rx.hostSampleSize, n);
+    }
+    timeNs = _rxTicksToTimeNs(_rx.fillTicks);
+    _rx.fillTicks += (long long)(n);
+    return n;
+}
+
+void bladeRF_SoapySDR::trackRxFill(void * const *buffs, const size_t numElems, const long long nextTicks)
+{
+    _rx.fillTicks = nextTicks;
+    if (_rx.gapFill != GAP_FILL_HOLD or numElems == 0) return;
+    for (size_t i = 0; i < _rx.chans.size(); i++)
+    {
+        const char *last = (const char *)buffs[i] + (numElems - 1) * _rx.hostSampleSize;
+        std::memcpy(_rx.holdSample.data() + i * _rx.hostSampleSize, last, _rx.hostSampleSize);
+    }
+}
+
+int bladeRF_SoapySDR::readStreamBatch(
+    void * const *buffs,
+    const size_t numElems,
+    int &flags,
+    long long &timeNs,
+    const long timeoutUs)
+{
+    //the first buffer reports errors and the time of the batch
+    int ret = this->readStreamSync(buffs, numElems, flags, timeNs, timeoutUs);
+    if (ret <= 0) return ret;
+    size_t total = size_t(ret);
+
+    //keep receiving while the samples are contiguous: an overflow or the end of a
+    //finite burst ends the batch, the next call reports the overflow as usual
+    std::vector<void *> chunkBuffs(_rx.chans.size());
+    while (total < numElems and not _rx.overflow and not _rx.cmds.empty())
+    {
+        for (size_t i = 0; i < chunkBuffs.size(); i++)
+        {
+            chunkBuffs[i] = reinterpret_cast<char *>(buffs[i]) + total * _rx.hostSampleSize;
+        }
+        int chunkFlags = 0;
+        long long chunkTimeNs = 0;
+        ret = this->readStreamSync(chunkBuffs.data(), numElems - total, chunkFlags, chunkTimeNs, timeoutUs);
+        if (ret <= 0) break; //the samples so far are returned, the error repeats on the next call
+        flags |= chunkFlags;
+        total += size_t(ret);
+    }
+    return int(total);
+}
+
 int bladeRF_SoapySDR::writeStream(
     SoapySDR::Stream *,
     const void * const *buffs,
@@ -443,26 +768,93 @@ int bladeRF_SoapySDR::writeStream(
     int &flags,
     const long long timeNs,
     const long timeoutUs)
+{
+    if (_tx.async != nullptr) return this->writeStreamAsync(buffs, numElems, flags, timeNs, timeoutUs);
+    if (_tx.ring != nullptr) return this->writeStreamRing(buffs, numElems, flags, timeNs, timeoutUs);
+    if (_tx.batch) return this->writeStreamBatch(buffs, numElems, flags, timeNs, timeoutUs);
+    return this->writeStreamSync(buffs, numElems, flags, timeNs, timeoutUs);
+}
+
+int bladeRF_SoapySDR::writeStreamSync(
+    const void * const *buffs,
+    size_t numElems,
+    int &flags,
+    const long long timeNs,
+    const long timeoutUs)
 {
     //clear EOB when the last sample will not be transmitted
-    if (numElems > _txBuffSize) flags &= ~(SOAPY_SDR_END_BURST);
+    if (numElems > _tx.buffSize) flags &= ~(SOAPY_SDR_END_BURST);
 
     //clip to the available conversion buffer size
-    numElems = std::min(numElems, _txBuffSize);
+    numElems = std::min(numElems, _tx.buffSize);
+
+    //prepare buffers, send directly from the input when the host format matches the wire
+    void *samples = (void *)buffs[0];
+    if (not _tx.converter->passthrough) samples = _tx.convBuff.data();
+
+    //perform the conversion into the wire format
+    if (samples != buffs[0]) _tx.converter->toWire(buffs, _tx.convBuff.data(), numElems);
+
+    return this->sendTxSamples(samples, numElems, flags, _timeNsToTxTicks(timeNs), timeoutUs/1000);
+}
+
+int bladeRF_SoapySDR::writeStreamBatch(
+    const void * const *buffs,
+    const size_t numElems,
+    int &flags,
+    const long long timeNs,
+    const long timeoutUs)
+{
+    //the time only applies to the first buffer, the following buffers continue the burst,
+    //and end of burst is kept only on the buffer that holds the last sample
+    const int endBurst = flags & SOAPY_SDR_END_BURST;
+    int chunkFlags = flags;
+    int ret = this->writeStreamSync(buffs, numElems, chunkFlags, timeNs, timeoutUs);
+    if (ret <= 0)
+    {
+        flags = chunkFlags;
+        return ret;
+    }
+    size_t total = size_t(ret);
+
+    std::vector<const void *> chunkBuffs(_tx.chans.size());
+    while (total < numElems)
+    {
+        for (size_t i = 0; i < chunkBuffs.size(); i++)
+        {
+            chunkBuffs[i] = reinterpret_cast<const char *>(buffs[i]) + total * _tx.hostSampleSize;
+        }
+        chunkFlags = endBurst;
+        ret = this->writeStreamSync(chunkBuffs.data(), numElems - total, chunkFlags, 0, timeoutUs);
+        if (ret <= 0) break; //the samples so far are reported, the caller resends the rest
+        total += size_t(ret);
+    }
+
+    //end of burst was only sent when every sample was
+    if (total < numElems) flags &= ~(SOAPY_SDR_END_BURST);
+    return int(total);
+}
 
+int bladeRF_SoapySDR::sendTxSamples(
+    const void *samples,
+    const size_t numElems,
+    const int flags,
+    const long long ticks,
+    const long timeoutMs)
+{
     //initialize metadata
     bladerf_metadata md;
     std::memset(&md, 0, sizeof(md));
 
     //stream is already in a burst and a new time was provided
     //update the metadata burst time with the provided time
-    if (_inTxBurst)
+    if (_tx.inBurst)
     {
         if ((flags & SOAPY_SDR_HAS_TIME) != 0)
         {
-            md.timestamp = _timeNsToTxTicks(timeNs);
+            md.timestamp = ticks;
             md.flags |= BLADERF_META_FLAG_TX_UPDATE_TIMESTAMP;
-            _txNextTicks = md.timestamp;
+            _tx.nextTicks = md.timestamp;
         }
     }
 
@@ -473,16 +865,16 @@ int bladeRF_SoapySDR::writeStream(
         //use the metadata to start the burst and set a timestamp if provided
         if ((flags & SOAPY_SDR_HAS_TIME) != 0)
         {
-            md.timestamp = _timeNsToTxTicks(timeNs);
-            _txNextTicks = md.timestamp;
+            md.timestamp = ticks;
+            _tx.nextTicks = md.timestamp;
         }
         //otherwise set now flag and record the rough time for reporting
         else
         {
             md.flags |= BLADERF_META_FLAG_TX_NOW;
-            bladerf_timestamp t;
-            bladerf_get_timestamp(_dev, BLADERF_TX, &t);
-            _txNextTicks = t;
+            bladerf_timestamp t = 0;
+            if (bladerf_get_timestamp(_dev, BLADERF_TX, &t) == 0) _timeModel.update(bladeRF_TimeModel::Clock::now(), _txTicksToTimeNs(t));
+            _tx.nextTicks = t;
         }
     }
 
@@ -492,46 +884,8 @@ int bladeRF_SoapySDR::writeStream(
         md.flags |= BLADERF_META_FLAG_TX_BURST_END;
     }
 
-    //prepare buffers
-    void *samples = (void *)buffs[0];
-    if (_txFloats or _txChans.size() == 2) samples = _txConvBuff;
-
-    //perform the float to int16 conversion
-    if (_txFloats and _txChans.size() == 1)
-    {
-        float *input = (float *)buffs[0];
-        for (size_t i = 0; i < 2 * numElems; i++)
-        {
-            _txConvBuff[i] = int16_t(input[i]*2048);
-        }
-    }
-    else if (not _txFloats and _txChans.size() == 2)
-    {
-        int16_t *input0 = (int16_t *)buffs[0];
-        int16_t *input1 = (int16_t *)buffs[1];
-        for (size_t i = 0; i < 4 * numElems;)
-        {
-            _txConvBuff[i++] = *(input0++);
-            _txConvBuff[i++] = *(input0++);
-            _txConvBuff[i++] = *(input1++);
-            _txConvBuff[i++] = *(input1++);
-        }
-    }
-    else if (_txFloats and _txChans.size() == 2)
-    {
-        float *input0 = (float *)buffs[0];
-        float *input1 = (float *)buffs[1];
-        for (size_t i = 0; i < 4 * numElems;)
-        {
-            _txConvBuff[i++] = int16_t(*(input0++)*2048);
-            _txConvBuff[i++] = int16_t(*(input0++)*2048);
-            _txConvBuff[i++] = int16_t(*(input1++)*2048);
-            _txConvBuff[i++] = int16_t(*(input1++)*2048);
-        }
-    }
-
     //send the tx samples
-    int ret = bladerf_sync_tx(_dev, samples, numElems*_txChans.size(), &md, timeoutUs/1000);
+    int ret = bladerf_sync_tx(_dev, samples, numElems*_tx.chans.size(), &md, timeoutMs);
     if (ret == BLADERF_ERR_TIMEOUT) return SOAPY_SDR_TIMEOUT;
     if (ret == BLADERF_ERR_TIME_PAST) return SOAPY_SDR_TIME_ERROR;
     if (ret != 0)
@@ -539,10 +893,10 @@ int bladeRF_SoapySDR::writeStream(
         SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_sync_tx() returned %s", _err2str(ret).c_str());
         return SOAPY_SDR_STREAM_ERROR;
     }
-    _txNextTicks += numElems;
+    _tx.nextTicks += numElems;
 
     //always in a burst after successful tx
-    _inTxBurst = true;
+    _tx.inBurst = true;
 
     //parse the status
     if ((md.status & BLADERF_META_STATUS_UNDERRUN) != 0)
@@ -551,7 +905,7 @@ int bladeRF_SoapySDR::writeStream(
         StreamMetadata resp;
         resp.flags = 0;
         resp.code = SOAPY_SDR_UNDERFLOW;
-        _txResps.push(resp);
+        this->pushTxResponse(resp);
     }
 
     //end burst status message
@@ -559,57 +913,527 @@ int bladeRF_SoapySDR::writeStream(
     {
         StreamMetadata resp;
         resp.flags = SOAPY_SDR_END_BURST | SOAPY_SDR_HAS_TIME;
-        resp.timeNs = this->_txTicksToTimeNs(_txNextTicks);
+        resp.timeNs = this->_txTicksToTimeNs(_tx.nextTicks);
         resp.code = 0;
-        _txResps.push(resp);
-        _inTxBurst = false;
+        this->pushTxResponse(resp);
+        _tx.inBurst = false;
     }
 
     return numElems;
 }
 
+void bladeRF_SoapySDR::pushTxResponse(const StreamMetadata &resp)
+{
+    std::lock_guard<std::mutex> lock(_tx.respMutex);
+    _tx.resps.push(resp);
+    _tx.respCond.notify_all();
+}
+
 int bladeRF_SoapySDR::readStreamStatus(
     SoapySDR::Stream *stream,
-    size_t &,
+    size_t &chanMask,
     int &flags,
     long long &timeNs,
     const long timeoutUs
 )
 {
-    const int direction = *reinterpret_cast<int *>(stream);
-    if (direction == SOAPY_SDR_RX) return SOAPY_SDR_NOT_SUPPORTED;
+    const int direction = reinterpret_cast<StreamContext *>(stream)->direction;
 
-    //wait for an event to be ready considering the timeout and time
-    //this is an emulation by polling and waiting on the hardware time
-    const auto exitTime = std::chrono::high_resolution_clock::now() + std::chrono::microseconds(timeoutUs);
-    while (true)
+    //rx events are queued by the reads and the streaming thread,
+    //waiting here only takes the event lock and never blocks the data path
+    if (direction == SOAPY_SDR_RX)
     {
-        //no status to report, sleep for a bit
-        if (_txResps.empty()) goto pollSleep;
-
-        //no time on the current status, done waiting...
-        if ((_txResps.front().flags & SOAPY_SDR_HAS_TIME) == 0) break;
+        std::unique_lock<std::mutex> lock(_rx.eventMutex);
+        if (not _rx.eventCond.wait_for(lock, std::chrono::microseconds(timeoutUs),
+            [this](void){return not _rx.events.empty();})) return SOAPY_SDR_TIMEOUT;
+        const StreamMetadata event = _rx.events.front();
+        _rx.events.pop();
+        lock.unlock();
+
+        chanMask = 0;
+        for (const auto ch : _rx.chans) chanMask |= size_t(1) << ch;
+        flags = event.flags;
+        timeNs = event.timeNs;
+        return event.code;
+    }
 
-        //current status time expired, done waiting...
-        if (_txResps.front().timeNs < this->getHardwareTime()) break;
+    //responses signal the condition variable, and a timed response is held until the host
+    //clock predicts that the hardware passed its time, so the device is not polled while waiting
+    const auto exitTime = bladeRF_TimeModel::Clock::now() + std::chrono::microseconds(timeoutUs);
+    std::unique_lock<std::mutex> lock(_tx.respMutex);
+    while (true)
+    {
+        auto wakeTime = exitTime;
+        if (not _tx.resps.empty())
+        {
+            //no time on the current status, done waiting...
+            if ((_tx.resps.front().flags & SOAPY_SDR_HAS_TIME) == 0) break;
+
+            //without a time model the hardware time is read once to start one
+            bladeRF_TimeModel::Clock::time_point expiry;
+            if (not _timeModel.toHostTime(_tx.resps.front().timeNs, expiry))
+            {
+                lock.unlock();
+                this->getHardwareTime();
+                lock.lock();
+                if (exitTime <= bladeRF_TimeModel::Clock::now()) return SOAPY_SDR_TIMEOUT;
+                continue;
+            }
 
-        //sleep a bit, never more than time remaining
-        pollSleep:
-        auto timeNow = std::chrono::high_resolution_clock::now();
-        auto timeLeft = std::chrono::duration_cast<std::chrono::microseconds>(exitTime - timeNow);
-        std::this_thread::sleep_for(std::chrono::microseconds(std::min<long>(1000, timeLeft.count())));
+            //current status time expired, done waiting...
+            if (expiry <= bladeRF_TimeModel::Clock::now()) break;
+            wakeTime = std::min(wakeTime, expiry);
+        }
 
         //check for timeout expired
-        if (exitTime < std::chrono::high_resolution_clock::now()) return SOAPY_SDR_TIMEOUT;
+        if (exitTime <= bladeRF_TimeModel::Clock::now()) return SOAPY_SDR_TIMEOUT;
+        _tx.respCond.wait_until(lock, wakeTime);
     }
 
     //extract the most recent status event
-    if (_txResps.empty()) return SOAPY_SDR_TIMEOUT;
-    StreamMetadata resp = _txResps.front();
-    _txResps.pop();
+    StreamMetadata resp = _tx.resps.front();
+    _tx.resps.pop();
+    lock.unlock();
 
     //load the output from the response
     flags = resp.flags;
     timeNs = resp.timeNs;
     return resp.code;
 }
+
+int bladeRF_SoapySDR::readStreamAsync(
+    void * const *buffs,
+    size_t numElems,
+    int &flags,
+    long long &timeNs,
+    const long timeoutUs)
+{
+    //the async formats do not carry timestamps
+    flags = 0;
+    timeNs = 0;
+
+    //acquire the next buffer once the previous one was consumed
+    if (_rx.asyncRemaining == 0)
+    {
+        const int ret = _rx.async->acquire(_rx.asyncHandle, timeoutUs);
+        if (ret == SOAPY_SDR_OVERFLOW)
+        {
+            SoapySDR::log(SOAPY_SDR_SSI, "O");
+            this->pushRxEvent(SOAPY_SDR_OVERFLOW, 0, 0);
+        }
+        if (ret != 0) return ret;
+        _rx.asyncOffset = 0;
+        _rx.asyncRemaining = _rx.async->getBufferSize() / _rx.chans.size();
+    }
+
+    //convert out of the buffer in place, it returns to the stream when consumed
+    numElems = std::min(numElems, _rx.asyncRemaining);
+    const size_t sampleSize = _wireSampleSize(_rx.format) * _rx.chans.size();
+    const char *input = (const char *)_rx.async->getBuffer(_rx.asyncHandle);
+    _rx.converter->toHost(input + _rx.asyncOffset * sampleSize, buffs, numElems);
+
+    _rx.asyncOffset += numElems;
+    _rx.asyncRemaining -= numElems;
+    if (_rx.asyncRemaining == 0) _rx.async->release(_rx.asyncHandle);
+    return numElems;
+}
+
+int bladeRF_SoapySDR::writeStreamAsync(
+    const void * const *buffs,
+    size_t numElems,
+    int &flags,
+    const long long,
+    const long timeoutUs)
+{
+    //the async formats do not carry timestamps
+    if ((flags & SOAPY_SDR_HAS_TIME) != 0) return SOAPY_SDR_NOT_SUPPORTED;
+
+    //acquire a free buffer to fill
+    if (not _tx.asyncAcquired)
+    {
+        const int ret = _tx.async->acquire(_tx.asyncHandle, timeoutUs);
+        if (ret != 0) return ret;
+        _tx.asyncOffset = 0;
+        _tx.asyncAcquired = true;
+    }
+
+    //clear EOB when the last sample will not be transmitted
+    const size_t available = _tx.async->getBufferSize() / _tx.chans.size() - _tx.asyncOffset;
+    if (numElems > available) flags &= ~(SOAPY_SDR_END_BURST);
+    numElems = std::min(numElems, available);
+
+    const size_t sampleSize = _wireSampleSize(_tx.format) * _tx.chans.size();
+    char *output = (char *)_tx.async->getBuffer(_tx.asyncHandle);
+    _tx.converter->toWire(buffs, output + _tx.asyncOffset * sampleSize, numElems);
+    _tx.asyncOffset += numElems;
+
+    //submit whole buffers, or a partial buffer padded with zeros to end the burst
+    if (numElems < available and (flags & SOAPY_SDR_END_BURST) == 0) return numElems;
+    std::memset(output + _tx.asyncOffset * sampleSize, 0, (available - numElems) * sampleSize);
+    const int ret = _tx.async->submit(_tx.asyncHandle, std::max<long>(1, timeoutUs/1000));
+    if (ret != 0)
+    {
+        //the samples were not accepted, they are written again on the next call
+        _tx.asyncOffset -= numElems;
+        if (ret == BLADERF_ERR_TIMEOUT) return SOAPY_SDR_TIMEOUT;
+        SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_submit_stream_buffer() returned %s", _err2str(ret).c_str());
+        return SOAPY_SDR_STREAM_ERROR;
+    }
+    _tx.asyncAcquired = false;
+    return numElems;
+}
+
+void bladeRF_SoapySDR::rxThreadLoop(StreamMetadata cmd)
+{
+    const size_t numChans = _rx.chans.size();
+    const long timeoutMs = std::max<long>(_rx.minTimeoutMs, 100);
+    std::vector<int16_t> discard(_rx.buffSize*2*numChans);
+    bool overflow = false;
+
+    while (_rx.threadRunning)
+    {
+        //receive into the next free block, or discard the samples when the ring is full
+        StreamBlock *block = _rx.ring->back();
+        int16_t *samples = (block == nullptr)? discard.data() : block->samples.data();
+        size_t numElems = _rx.buffSize;
+        if (cmd.numElems > 0) numElems = std::min(cmd.numElems, numElems);
+
+        //without a soapy sdr time flag, set the blade rf now flag
+        bladerf_metadata md;
+        std::memset(&md, 0, sizeof(md));
+        if ((cmd.flags & SOAPY_SDR_HAS_TIME) == 0) md.flags |= BLADERF_META_FLAG_RX_NOW;
+        md.timestamp = _timeNsToRxTicks(cmd.timeNs);
+
+        int ret = bladerf_sync_rx(_dev, samples, numElems*numChans, &md, timeoutMs);
+        if (ret == BLADERF_ERR_TIMEOUT) continue;
+        cmd.flags = 0; //clear flags for subsequent calls
+
+        //errors are queued in order with the samples
+        if (ret != 0)
+        {
+            const bool timeError = (ret == BLADERF_ERR_TIME_PAST);
+            if (not timeError) SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_sync_rx() returned %s", _err2str(ret).c_str());
+            if (timeError) this->pushRxEvent(SOAPY_SDR_TIME_ERROR, SOAPY_SDR_HAS_TIME, md.timestamp);
+            else this->pushRxEvent(SOAPY_SDR_STREAM_ERROR, 0, 0);
+            if (block != nullptr)
+            {
+                block->numElems = 0;
+                block->ticks = md.timestamp;
+                block->flags = 0;
+                block->code = timeError?SOAPY_SDR_TIME_ERROR:SOAPY_SDR_STREAM_ERROR;
+                _rx.ring->push();
+            }
+            if (timeError) continue;
+            break;
+        }
+
+        //a full ring is an overflow, reported ahead of the next queued block
+        if (block == nullptr)
+        {
+            overflow = true;
+            continue;
+        }
+
+        block->numElems = md.actual_count / numChans;
+        block->ticks = md.timestamp;
+        this->accountRxTicks(block->ticks, block->numElems, (md.flags & BLADERF_META_FLAG_RX_NOW) != 0);
+        _timeModel.bound(bladeRF_TimeModel::Clock::now(), _rxTicksToTimeNs(block->ticks + block->numElems));
+        block->flags = 0;
+        block->code = overflow?SOAPY_SDR_OVERFLOW:0;
+        overflow = (md.status & BLADERF_META_STATUS_OVERRUN) != 0;
+
+        //add flags specific to BladeRF from bladerf_sync_rx.status.
+        #if defined(SOAPY_SDR_USER_FLAG0) and defined(SOAPY_SDR_USER_FLAG1)
+        if ((md.status & BLADERF_META_FLAG_RX_HW_MINIEXP1) != 0) block->flags |= SOAPY_SDR_USER_FLAG0;
+        if ((md.status & BLADERF_META_FLAG_RX_HW_MINIEXP2) != 0) block->flags |= SOAPY_SDR_USER_FLAG1;
+        #endif
+
+        //consume from the command if this is a finite burst
+        bool done = false;
+        if (cmd.numElems > 0)
+        {
+            cmd.numElems -= std::min(cmd.numElems, block->numElems);
+            done = (cmd.numElems == 0);
+            if (done) block->flags |= SOAPY_SDR_END_BURST;
+            if (done) this->pushRxEvent(0, SOAPY_SDR_END_BURST | SOAPY_SDR_HAS_TIME, block->ticks + block->numElems);
+        }
+
+        _rx.ring->push();
+        if (done) break;
+    }
+}
+
+void bladeRF_SoapySDR::stopRxThread(void)
+{
+    _rx.threadRunning = false;
+    if (_rx.thread.joinable()) _rx.thread.join();
+}
+
+void bladeRF_SoapySDR::accountRxTicks(const long long ticks, const size_t numElems, const bool continuous)
+{
+    //a timed read starts a new timeline, so only continuous reads can have gaps,
+    //the blocks discarded by a full ring show up as a gap before the next queued block
+    if (continuous and _rx.expectTicks >= 0 and ticks > _rx.expectTicks)
+    {
+        const long long dropped = ticks - _rx.expectTicks;
+        SoapySDR::logf(SOAPY_SDR_DEBUG, "RX dropped %lld samples", dropped);
+        _rx.droppedSamples += (unsigned long long)(dropped);
+        this->pushRxEvent(SOAPY_SDR_OVERFLOW, SOAPY_SDR_HAS_TIME, _rx.expectTicks, size_t(dropped));
+    }
+    _rx.expectTicks = ticks + (long long)(numElems);
+}
+
+void bladeRF_SoapySDR::recordRxLatency(const long long timeNs)
+{
+    long long nowNs = 0;
+    if (not _timeModel.toTimeNs(bladeRF_TimeModel::Clock::now(), nowNs)) return;
+    _rx.latency.record(nowNs - timeNs);
+}
+
+void bladeRF_SoapySDR::pushRxEvent(const int code, const int flags, const long long ticks, const size_t numElems)
+{
+    StreamMetadata event;
+    event.flags = flags;
+    event.timeNs = ((flags & SOAPY_SDR_HAS_TIME) != 0)? _rxTicksToTimeNs(ticks) : 0;
+    event.numElems = numElems;
+    event.code = code;
+
+    std::lock_guard<std::mutex> lock(_rx.eventMutex);
+    if (_rx.events.size() >= MAX_STATUS_EVENTS) _rx.events.pop();
+    _rx.events.push(event);
+    _rx.eventCond.notify_all();
+}
+
+void bladeRF_SoapySDR::txThreadLoop(void)
+{
+    while (_tx.threadRunning)
+    {
+        StreamBlock *block = _tx.ring->front();
+        if (block == nullptr)
+        {
+            _tx.ring->waitFront(100000);
+            continue;
+        }
+
+        //a timeout leaves the block in the ring to try again
+        const int ret = this->sendTxSamples(block->samples.data(), block->numElems, block->flags, block->ticks, 100);
+        if (ret == SOAPY_SDR_TIMEOUT) continue;
+
+        //errors are reported through the stream status
+        if (ret < 0)
+        {
+            StreamMetadata resp;
+            resp.flags = 0;
+            resp.code = ret;
+            this->pushTxResponse(resp);
+        }
+
+        _tx.ring->pop();
+    }
+}
+
+void bladeRF_SoapySDR::stopTxThread(void)
+{
+    _tx.threadRunning = false;
+    if (_tx.thread.joinable()) _tx.thread.join();
+}
+
+int bladeRF_SoapySDR::writeStreamRing(
+    const void * const *buffs,
+    size_t numElems,
+    int &flags,
+    const long long timeNs,
+    const long timeoutUs)
+{
+    //a new time starts a new block, so the time applies to its first sample
+    StreamBlock *block = _tx.ring->back();
+    if (block != nullptr and _tx.ringFill != 0 and (flags & SOAPY_SDR_HAS_TIME) != 0)
+    {
+        block->numElems = _tx.ringFill;
+        _tx.ringFill = 0;
+        _tx.ring->push();
+        block = _tx.ring->back();
+    }
+
+    //only wait when the ring is full, a zero timeout never blocks
+    if (block == nullptr and _tx.ring->waitBack(timeoutUs)) block = _tx.ring->back();
+    if (block == nullptr) return SOAPY_SDR_TIMEOUT;
+
+    if (_tx.ringFill == 0)
+    {
+        block->flags = flags & SOAPY_SDR_HAS_TIME;
+        block->ticks = _timeNsToTxTicks(timeNs);
+        block->code = 0;
+    }
+
+    //clear EOB when the last sample will not be transmitted
+    const size_t available = _tx.buffSize - _tx.ringFill;
+    if (numElems > available) flags &= ~(SOAPY_SDR_END_BURST);
+    numElems = std::min(numElems, available);
+
+    const size_t sampleSize = _wireSampleSize(_tx.format) * _tx.chans.size();
+    char *output = (char *)block->samples.data();
+    _tx.converter->toWire(buffs, output + _tx.ringFill * sampleSize, numElems);
+    _tx.ringFill += numElems;
+
+    //hand whole blocks and the end of a burst to the streaming thread
+    if ((flags & SOAPY_SDR_END_BURST) != 0) block->flags |= SOAPY_SDR_END_BURST;
+    if (_tx.ringFill == _tx.buffSize or (flags & SOAPY_SDR_END_BURST) != 0)
+    {
+        block->numElems = _tx.ringFill;
+        _tx.ringFill = 0;
+        _tx.ring->push();
+    }
+
+    return numElems;
+}
+
+int bladeRF_SoapySDR::readStreamRing(
+    void * const *buffs,
+    size_t numElems,
+    int &flags,
+    long long &timeNs,
+    const long timeoutUs)
+{
+    //only wait when the ring is empty, a zero timeout never blocks
+    StreamBlock *block = _rx.ring->front();
+    if (block == nullptr and _rx.ring->waitFront(timeoutUs)) block = _rx.ring->front();
+    if (block == nullptr) return SOAPY_SDR_TIMEOUT;
+
+    flags = SOAPY_SDR_HAS_TIME;
+    timeNs = _rxTicksToTimeNs(block->ticks + _rx.ringOffset);
+
+    //report the status ahead of the samples in this block
+    if (block->code != 0)
+    {
+        const int code = block->code;
+        block->code = 0;
+        if (code == SOAPY_SDR_OVERFLOW) SoapySDR::log(SOAPY_SDR_SSI, "O");
+        if (block->numElems == 0) _rx.ring->pop();
+        return code;
+    }
+
+    //synthesize the samples missing ahead of the block
+    const size_t filled = this->fillRxGap(buffs, numElems, block->ticks + (long long)(_rx.ringOffset), timeNs);
+    if (filled != 0) return int(filled);
+
+    //convert out of the block, it returns to the ring when consumed
+    numElems = std::min(numElems, block->numElems - _rx.ringOffset);
+    const size_t sampleSize = _wireSampleSize(_rx.format) * _rx.chans.size();
+    const char *input = (const char *)block->samples.data();
+    _rx.converter->toHost(input + _rx.ringOffset * sampleSize, buffs, numElems);
+
+    _rx.ringOffset += numElems;
+    _rx.nextTicks = block->ticks + _rx.ringOffset;
+    if (_rx.gapFill != GAP_FILL_NONE) this->trackRxFill(buffs, numElems, _rx.nextTicks);
+    this->recordRxLatency(timeNs);
+    if (_rx.ringOffset == block->numElems)
+    {
+        flags |= block->flags;
+        _rx.ringOffset = 0;
+        _rx.ring->pop();
+    }
+    else flags |= (block->flags & ~SOAPY_SDR_END_BURST);
+
+    return numElems;
+}
+
+/*******************************************************************
+ * Direct buffer access API
+ ******************************************************************/
+
+bool bladeRF_SoapySDR::directAccessCompatible(const int direction) const
+{
+    //the buffers are handed out in the wire format, and the two channel
+    //wire format is interleaved, so there are no per-channel buffers
+    if (direction == SOAPY_SDR_RX) return _rx.async != nullptr and _rx.converter->passthrough;
+    return _tx.async != nullptr and _tx.converter->passthrough;
+}
+
+size_t bladeRF_SoapySDR::getNumDirectAccessBuffers(SoapySDR::Stream *stream)
+{
+    const int direction = reinterpret_cast<StreamContext *>(stream)->direction;
+    if (not this->directAccessCompatible(direction)) return 0;
+    return ((direction == SOAPY_SDR_RX)?_rx.async:_tx.async)->getNumBuffers();
+}
+
+int bladeRF_SoapySDR::getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const size_t handle, void **buffs)
+{
+    const int direction = reinterpret_cast<StreamContext *>(stream)->direction;
+    if (not this->directAccessCompatible(direction)) return SOAPY_SDR_NOT_SUPPORTED;
+    auto async = (direction == SOAPY_SDR_RX)?_rx.async:_tx.async;
+    if (handle >= async->getNumBuffers()) return SOAPY_SDR_STREAM_ERROR;
+    buffs[0] = async->getBuffer(handle);
+    return 0;
+}
+
+int bladeRF_SoapySDR::acquireReadBuffer(
+    SoapySDR::Stream *,
+    size_t &handle,
+    const void **buffs,
+    int &flags,
+    long long &timeNs,
+    const long timeoutUs)
+{
+    if (not this->directAccessCompatible(SOAPY_SDR_RX)) return SOAPY_SDR_NOT_SUPPORTED;
+
+    //the async formats do not carry timestamps
+    flags = 0;
+    timeNs = 0;
+
+    const int ret = _rx.async->acquire(handle, timeoutUs);
+    if (ret == SOAPY_SDR_OVERFLOW)
+    {
+        SoapySDR::log(SOAPY_SDR_SSI, "O");
+        this->pushRxEvent(SOAPY_SDR_OVERFLOW, 0, 0);
+    }
+    if (ret != 0) return ret;
+
+    buffs[0] = _rx.async->getBuffer(handle);
+    return int(_rx.async->getBufferSize());
+}
+
+void bladeRF_SoapySDR::releaseReadBuffer(
+    SoapySDR::Stream *,
+    const size_t handle)
+{
+    if (_rx.async != nullptr) _rx.async->release(handle);
+}
+
+int bladeRF_SoapySDR::acquireWriteBuffer(
+    SoapySDR::Stream *,
+    size_t &handle,
+    void **buffs,
+    const long timeoutUs)
+{
+    if (not this->directAccessCompatible(SOAPY_SDR_TX)) return SOAPY_SDR_NOT_SUPPORTED;
+
+    const int ret = _tx.async->acquire(handle, timeoutUs);
+    if (ret != 0) return ret;
+
+    buffs[0] = _tx.async->getBuffer(handle);
+    return int(_tx.async->getBufferSize());
+}
+
+void bladeRF_SoapySDR::releaseWriteBuffer(
+    SoapySDR::Stream *,
+    const size_t handle,
+    const size_t numElems,
+    int &,
+    const long long)
+{
+    if (_tx.async == nullptr) return;
+
+    //the stream always transmits whole buffers, pad a partial buffer with zeros
+    const size_t bufSize = _tx.async->getBufferSize();
+    const size_t sampleSize = _wireSampleSize(_tx.format);
+    char *output = (char *)_tx.async->getBuffer(handle);
+    if (numElems < bufSize) std::memset(output + numElems * sampleSize, 0, (bufSize - numElems) * sampleSize);
+
+    const int ret = _tx.async->submit(handle, 1000); //1 second timeout
+    if (ret != 0)
+    {
+        SoapySDR::logf(SOAPY_SDR_ERROR, "bladerf_submit_stream_buffer() returned %s", _err2str(ret).c_str());
+        _tx.async->release(handle);
+    }
+}
@@ -0,0 +1,180 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "bladeRF_TimeModel.hpp"
+#include <algorithm> //min, max
+#include <cstdlib> //llabs
+
+//a read that disagrees by more than this restarts the model instead of steering it
+#define TIME_MODEL_RESET_NS 1000000
+
+//the device clock is within this fraction of the host clock
+#define TIME_MODEL_MAX_DRIFT 500e-6
+
+//loop gains: the fraction of the phase error applied on each read,
+//and the fraction of the implied frequency error applied to the rate
+#define TIME_MODEL_PHASE_GAIN 0.5
+#define TIME_MODEL_RATE_GAIN 0.1
+
+bladeRF_TimeModel::bladeRF_TimeModel(void):
+    _seq(0),
+    _valid(false),
+    _anchorHost(0),
+    _anchorNs(0),
+    _lastRead(0),
+    _rate(1.0)
+{
+    return;
+}
+
+void bladeRF_TimeModel::reset(void)
+{
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    State state = this->load();
+    state.valid = false;
+    state.anchorNs = 0;
+    state.rate = 1.0;
+    this->store(state);
+}
+
+void bladeRF_TimeModel::set(const Clock::time_point hostTime, const long long timeNs)
+{
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    State state = this->load();
+    state.anchorHost = hostTime;
+    state.anchorNs = timeNs;
+    state.lastRead = hostTime;
+    state.valid = true;
+    this->store(state);
+}
+
+void bladeRF_TimeModel::update(const Clock::time_point hostTime, const long long timeNs)
+{
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    State state = this->load();
+    const Clock::time_point previousRead = state.lastRead;
+    state.lastRead = hostTime;
+
+    //the first read, or a time change, starts over from the measurement
+    const long long errorNs = state.valid? timeNs - predict(state, hostTime) : 0;
+    if (not state.valid or std::llabs(errorNs) > TIME_MODEL_RESET_NS)
+    {
+        state.anchorHost = hostTime;
+        state.anchorNs = timeNs;
+        state.valid = true;
+        this->store(state);
+        return;
+    }
+
+    //steer the rate by the error over the time since the previous read, then move the anchor,
+    //the anchor also moves with stream metadata so it can be far too recent for the rate
+    const long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(hostTime - previousRead).count();
+    const long long predictedNs = timeNs - errorNs;
+    if (elapsedNs > 0)
+    {
+        state.rate += TIME_MODEL_RATE_GAIN * double(errorNs) / double(elapsedNs);
+        state.rate = std::min(1.0 + TIME_MODEL_MAX_DRIFT, std::max(1.0 - TIME_MODEL_MAX_DRIFT, state.rate));
+    }
+    state.anchorHost = hostTime;
+    state.anchorNs = predictedNs + (long long)(TIME_MODEL_PHASE_GAIN * double(errorNs));
+    this->store(state);
+}
+
+void bladeRF_TimeModel::bound(const Clock::time_point hostTime, const long long timeNs)
+{
+    //this runs for every received buffer, check without taking the lock
+    State state = this->load();
+    if (not state.valid) return;
+
+    //the estimate is behind samples that were already received, pull it forward,
+    //only the offset moves, the rate is steered by the hardware reads
+    long long predictedNs = predict(state, hostTime);
+    if (timeNs <= predictedNs or timeNs - predictedNs > TIME_MODEL_RESET_NS) return;
+
+    //a busy writer is updating from a hardware read, the next buffer bounds again
+    std::unique_lock<std::mutex> lock(_writeMutex, std::try_to_lock);
+    if (not lock.owns_lock()) return;
+    state = this->load();
+    predictedNs = predict(state, hostTime);
+    if (not state.valid or timeNs <= predictedNs or timeNs - predictedNs > TIME_MODEL_RESET_NS) return;
+    state.anchorHost = hostTime;
+    state.anchorNs = timeNs;
+    this->store(state);
+}
+
+bool bladeRF_TimeModel::fresh(const Clock::time_point hostTime, const Clock::duration maxAge) const
+{
+    const State state = this->load();
+    return state.valid and hostTime - state.lastRead < maxAge;
+}
+
+bool bladeRF_TimeModel::toTimeNs(const Clock::time_point hostTime, long long &timeNs) const
+{
+    const State state = this->load();
+    if (not state.valid) return false;
+    timeNs = predict(state, hostTime);
+    return true;
+}
+
+bool bladeRF_TimeModel::toHostTime(const long long timeNs, Clock::time_point &hostTime) const
+{
+    const State state = this->load();
+    if (not state.valid) return false;
+    const double elapsedNs = double(timeNs - state.anchorNs) / state.rate;
+    hostTime = state.anchorHost + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds((long long)(elapsedNs)));
+    return true;
+}
+
+long long bladeRF_TimeModel::predict(const State &state, const Clock::time_point hostTime)
+{
+    const long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(hostTime - state.anchorHost).count();
+    return state.anchorNs + (long long)(state.rate * double(elapsedNs));
+}
+
+bladeRF_TimeModel::State bladeRF_TimeModel::load(void) const
+{
+    State state;
+    while (true)
+    {
+        const unsigned long long seq = _seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) continue;
+        state.valid = _valid.load(std::memory_order_relaxed);
+        state.anchorHost = Clock::time_point(Clock::duration(_anchorHost.load(std::memory_order_relaxed)));
+        state.anchorNs = _anchorNs.load(std::memory_order_relaxed);
+        state.lastRead = Clock::time_point(Clock::duration(_lastRead.load(std::memory_order_relaxed)));
+        state.rate = _rate.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) == seq) return state;
+    }
+}
+
+void bladeRF_TimeModel::store(const State &state)
+{
+    const unsigned long long seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _valid.store(state.valid, std::memory_order_relaxed);
+    _anchorHost.store(state.anchorHost.time_since_epoch().count(), std::memory_order_relaxed);
+    _anchorNs.store(state.anchorNs, std::memory_order_relaxed);
+    _lastRead.store(state.lastRead.time_since_epoch().count(), std::memory_order_relaxed);
+    _rate.store(state.rate, std::memory_order_relaxed);
+    _seq.store(seq + 2, std::memory_order_release);
+}
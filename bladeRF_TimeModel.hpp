@@ -0,0 +1,96 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+/*!
+ * Model of the hardware time as a function of the host steady clock.
+ * Hardware time reads are fed in as measurements and track both the offset
+ * and the rate of the device clock, so the time can be extrapolated between
+ * reads without a USB transfer. Stream metadata only proves that the device
+ * already reached a time, so it is applied as a lower bound on the estimate.
+ * All times are in nanoseconds, the methods are thread safe.
+ * The model is published with a sequence lock: readers never take a lock,
+ * writers are serialized and a bound skips its update while another writer is busy.
+ */
+class bladeRF_TimeModel
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    bladeRF_TimeModel(void);
+
+    //! forget all measurements, the next one starts a new model
+    void reset(void);
+
+    //! restart the model from a time that was just set on the device, the rate is kept
+    void set(const Clock::time_point hostTime, const long long timeNs);
+
+    //! a hardware time read at hostTime
+    void update(const Clock::time_point hostTime, const long long timeNs);
+
+    //! the device was at or past timeNs at hostTime, from stream metadata
+    void bound(const Clock::time_point hostTime, const long long timeNs);
+
+    //! true when a hardware time read was fed in within maxAge
+    bool fresh(const Clock::time_point hostTime, const Clock::duration maxAge) const;
+
+    //! the estimated hardware time at hostTime, false without a model
+    bool toTimeNs(const Clock::time_point hostTime, long long &timeNs) const;
+
+    //! the host time at which the hardware reaches timeNs, false without a model
+    bool toHostTime(const long long timeNs, Clock::time_point &hostTime) const;
+
+private:
+    //! a consistent copy of the model
+    struct State
+    {
+        bool valid;
+        Clock::time_point anchorHost;
+        long long anchorNs;
+        //! the last hardware read, the rate is estimated over the time between reads
+        Clock::time_point lastRead;
+        //! hardware nanoseconds per host nanosecond
+        double rate;
+    };
+
+    static long long predict(const State &state, const Clock::time_point hostTime);
+
+    //! copy the model without locking, retried while a writer is storing
+    State load(void) const;
+
+    //! publish the model, only with _writeMutex held
+    void store(const State &state);
+
+    std::mutex _writeMutex;
+
+    //! odd while a writer is storing
+    std::atomic<unsigned long long> _seq;
+    std::atomic<bool> _valid;
+    std::atomic<Clock::rep> _anchorHost;
+    std::atomic<long long> _anchorNs;
+    std::atomic<Clock::rep> _lastRead;
+    std::atomic<double> _rate;
+};
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the bladeRF project:
+ *   http://www.github.com/nuand/bladeRF
+ *
+ * Copyright (C) 2025 Nuand LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include "bladeRF_RationalScale.hpp"
+#include <atomic>
+#include <cstddef>
+
+/*!
+ * Piecewise mapping between a device tick counter and time in nanoseconds.
+ * A sample rate change starts a new segment at the tick count where it took
+ * effect, so the counter keeps running across the change and earlier ticks
+ * keep their times. The last 7 segments are kept for samples that were in
+ * flight across a change. Conversions are lock free: one thread changes
+ * the timeline while any thread converts.
+ */
+class bladeRF_Timeline
+{
+public:
+    bladeRF_Timeline(void):
+        _count(0)
+    {
+        this->append(0, bladeRF_RationalScale(), bladeRF_RationalScale());
+    }
+
+    //! continue at the rate of the scales from startTicks on
+    void append(long long startTicks, const bladeRF_RationalScale &toNs, const bladeRF_RationalScale &toTicks)
+    {
+        const size_t n = _count.load(std::memory_order_relaxed);
+        Segment &seg = _segments[n % NUM_SEGMENTS];
+        seg.first = n;
+        seg.startTicks = 0;
+        seg.startNs = 0;
+        if (n != 0)
+        {
+            //the new segment starts where the current one is at that tick count
+            const Segment &prev = _segments[(n - 1) % NUM_SEGMENTS];
+            if (startTicks < prev.startTicks) startTicks = prev.startTicks;
+            seg.first = prev.first;
+            seg.startTicks = startTicks;
+            seg.startNs = prev.startNs + prev.toNs(startTicks - prev.startTicks);
+        }
+        seg.toNs = toNs;
+        seg.toTicks = toTicks;
+        _count.store(n + 1, std::memory_order_release);
+    }
+
+    //! the counter was reset, a single segment from tick zero at the current rate
+    void restart(void)
+    {
+        const size_t n = _count.load(std::memory_order_relaxed);
+        const Segment &prev = _segments[(n - 1) % NUM_SEGMENTS];
+        Segment &seg = _segments[n % NUM_SEGMENTS];
+        seg.toNs = prev.toNs;
+        seg.toTicks = prev.toTicks;
+        seg.first = n;
+        seg.startTicks = 0;
+        seg.startNs = 0;
+        _count.store(n + 1, std::memory_order_release);
+    }
+
+    long long ticksToNs(const long long ticks) const
+    {
+        const Segment &seg = this->find([ticks](const Segment &s){return ticks >= s.startTicks;});
+        return seg.startNs + seg.toNs(ticks - seg.startTicks);
+    }
+
+    long long nsToTicks(const long long timeNs) const
+    {
+        const Segment &seg = this->find([timeNs](const Segment &s){return timeNs >= s.startNs;});
+        return seg.startTicks + seg.toTicks(timeNs - seg.startNs);
+    }
+
+private:
+    struct Segment
+    {
+        size_t first; //!< the oldest segment since the counter started
+        long long startTicks;
+        long long startNs;
+        bladeRF_RationalScale toNs;
+        bladeRF_RationalScale toTicks;
+    };
+
+    static const size_t NUM_SEGMENTS = 8;
+
+    //! the newest segment that contains the point, the oldest one extrapolates backwards
+    template <typename Contains>
+    const Segment &find(Contains contains) const
+    {
+        const size_t n = _count.load(std::memory_order_acquire);
+        size_t i = n - 1;
+        const Segment &last = _segments[i % NUM_SEGMENTS];
+        if (contains(last)) return last;
+        //the slot of segment n-NUM_SEGMENTS is the one the next change overwrites
+        //while it is being read, so the lookback stops one segment short of it
+        size_t oldest = (n >= NUM_SEGMENTS)? n - (NUM_SEGMENTS - 1) : 0;
+        if (oldest < last.first) oldest = last.first;
+        while (i > oldest and not contains(_segments[i % NUM_SEGMENTS])) i--;
+        return _segments[i % NUM_SEGMENTS];
+    }
+
+    Segment _segments[NUM_SEGMENTS];
+    std::atomic<size_t> _count;
+};